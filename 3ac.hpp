@@ -6,6 +6,7 @@
 #include <map>
 #include <set>
 #include <string.h>
+#include <vector>
 #include "symbol_table.hpp"
 #include "types.hpp"
 
@@ -23,6 +24,9 @@ public:
 	std::string toString(){
 		return this->name;
 	}
+	void setName(std::string nameIn){
+		this->name = nameIn;
+	}
 private:
 	std::string name;
 };
@@ -54,10 +58,10 @@ public:
 		return "[" + mySym->getName() + "]";
 	}
 	virtual std::string locString() override{
-		return mySym->getName();
+		return mySym->getName().str();
 	}
 	virtual std::string getName(){
-		return mySym->getName();
+		return mySym->getName().str();
 	}
 	const SemSymbol * getSym(){ return mySym; }
 private:
@@ -112,6 +116,9 @@ public:
 	virtual std::string getName(){
 		return name;
 	}
+	void setName(std::string nameIn){
+		name = nameIn;
+	}
 private:
 	std::string val;
 	std::string name;
@@ -135,6 +142,9 @@ public:
 	std::string commentStr();
 	virtual std::string toString(bool verbose=false);
 	void setComment(std::string commentIn);
+	//The (comma-separated) labels of a quad, padded out to
+	// the width of the label column
+	static std::string labelColumn(const std::string& labelText);
 private:
 	std::string myComment;
 	std::list<Label *> labels;
@@ -292,9 +302,35 @@ private:
 	Opd * opd;
 };
 
+//The finished 3AC of one procedure, in a form that can be
+// spliced into a different IRProgram (see ProcCache). Labels
+// and string constants are numbered program-wide, so the body
+// refers to them by placeholders relative to the procedure,
+// which IRProgram::instantiate renumbers.
+class ProcTemplate{
+public:
+	ProcTemplate(std::string nameIn) : name(nameIn), labelCount(0){ }
+	std::string name;
+	std::string body;
+	size_t labelCount;
+	std::vector<std::string> strings;
+
+	//Whether every placeholder in the body is well formed and
+	// names one of the template's labels or strings, so that
+	// IRProgram::instantiate cannot fail on it
+	bool wellFormed() const;
+
+	static std::string placeholder(char kind, size_t index){
+		return "\x01" + std::string(1, kind) 
+			+ std::to_string(index) + "\x01";
+	}
+};
+
 class Procedure{
 public:
 	Procedure(IRProgram * prog, std::string name);
+	//A procedure whose 3AC was already rendered elsewhere
+	Procedure(IRProgram * prog, std::string name, std::string text);
 	void addQuad(Quad * quad);
 	Quad * popQuad();
 	IRProgram * getProg();
@@ -303,7 +339,9 @@ public:
 
 	void gatherLocal(SemSymbol * sym);
 	void gatherFormal(SemSymbol * sym);
-	SymOpd * getSymOpd(SemSymbol * sym);
+	//The operand of the variable at slot of a scope at
+	// depth (see SemSymbol::getSlot)
+	SymOpd * getSymOpd(uint32_t depth, uint32_t slot);
 	AuxOpd * makeTmp(size_t width);
 	AddrOpd * makeAddrOpd(size_t width);
 
@@ -311,19 +349,32 @@ public:
 	std::string getName();
 
 	crona::Label * getLeaveLabel();
+	bool isSpliced(){ return spliced; }
+	size_t getLabelBase(){ return labelBase; }
+	size_t getStringBase(){ return stringBase; }
 private:
 	EnterQuad * enter;
 	LeaveQuad * leave;
 	Label * leaveLabel;
 
+	void fillSlot(SemSymbol * sym, SymOpd * opd);
+
 	IRProgram * myProg;
-	std::map<SemSymbol *, SymOpd *> locals;
+	//The formals' and locals' operands, by slot
+	std::vector<SymOpd *> slots;
 	std::list<AuxOpd *> temps; 
 	std::list<SymOpd *> formals; 
 	std::list<AddrOpd *> addrOpds;
 	std::list<Quad *> * bodyQuads;
 	std::string myName;
 	size_t maxTmp;
+
+	//The program-wide label and string counters at the 
+	// point this procedure was started
+	size_t labelBase;
+	size_t stringBase;
+	bool spliced;
+	std::string splicedText;
 };
 
 class IRProgram{
@@ -336,10 +387,17 @@ public:
 	Label * makeLabel();
 	Opd * makeString(std::string val);
 	void gatherGlobal(SemSymbol * sym);
-	SymOpd * getGlobal(SemSymbol * sym);
+	SymOpd * getGlobal(uint32_t slot);
 	size_t opWidth(ASTNode * node);
 	const DataType * nodeType(ASTNode * node);
 	std::set<Opd *> globalSyms();
+	size_t labelCount(){ return max_label; }
+	size_t stringCount(){ return str_idx; }
+
+	//Capture the finished 3AC of proc so that it can be 
+	// instantiated in another program
+	ProcTemplate * makeTemplate(Procedure * proc);
+	Procedure * instantiate(const ProcTemplate * tmpl);
 
 	std::string toString(bool verbose=false);
 private:
@@ -348,7 +406,10 @@ private:
 	size_t str_idx = 0;
 	std::list<Procedure *> * procs; 
 	HashMap<AddrOpd *, std::string> strings;
-	std::map<SemSymbol *, SymOpd *> globals;
+	std::vector<Label *> labels;
+	std::vector<AddrOpd *> stringOpds;
+	//The globals' operands, by slot
+	std::vector<SymOpd *> globals;
 };
 
 }
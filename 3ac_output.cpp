@@ -1,20 +1,27 @@
 #include "ast.hpp"
+#include "time_report.hpp"
 #include <iostream>
 
 namespace crona{
 
 IRProgram * ProgramNode::to3AC(TypeAnalysis * ta){
 	IRProgram * prog = new IRProgram(ta);
-	for (auto global : *myGlobals){
+	for (auto global : myGlobals){
 		global->to3AC(prog);
 	}
 	return prog;
 }
 
 void FnDeclNode::to3AC(IRProgram * prog){
-	Procedure * p = prog->makeProc(myID->getName());
+	FunctionTimer timer(myID->getName());
+	if (myTemplate != nullptr){
+		prog->instantiate(myTemplate);
+		return;
+	}
+
+	Procedure * p = prog->makeProc(myID->getName().str());
 
-	for(auto f : *myFormals){
+	for(auto f : myFormals){
 		f->to3AC(p);
 	}
 
@@ -27,7 +34,7 @@ void FnDeclNode::to3AC(IRProgram * prog){
 		idx++;
 	}
 
-	for(auto b : *myBody){
+	for(auto b : body()){
 		b->to3AC(p);
 	}
 
@@ -68,7 +75,7 @@ Opd * IntLitNode::flatten(Procedure * proc){
 }
 
 Opd * StrLitNode::flatten(Procedure * proc){
-	Opd * res = proc->getProg()->makeString(myStr);
+	Opd * res = proc->getProg()->makeString(myStr.str());
 	return res;
 }
 
@@ -106,7 +113,7 @@ Opd * LValNode::flatten(Procedure * proc){
 
 Opd * CallExpNode::flatten(Procedure * proc){
 	std::list<Opd*> opdList;
-	for(auto arg : *myArgs)
+	for(auto arg : myArgs)
 	{
 		opdList.push_back(arg->flatten(proc));
 	}
@@ -393,7 +400,7 @@ void IfStmtNode::to3AC(Procedure * proc){
 	Label* exitIf = proc->makeLabel();
 	Quad* jumpIf = new JmpIfQuad(condOpd, exitIf);
 	proc->addQuad(jumpIf);
-	for (auto stmt: *myBody){
+	for (auto stmt: myBody){
 		stmt->to3AC(proc);
 	}
 	Quad* exit = new NopQuad();
@@ -407,7 +414,7 @@ void IfElseStmtNode::to3AC(Procedure * proc){
 	Quad* jumpElse = new JmpIfQuad(condOpd, elseLbl);
 	proc->addQuad(jumpElse);
 	
-	for (auto stmt: *myBodyTrue){
+	for (auto stmt: myBodyTrue){
 		stmt->to3AC(proc);
 	}
 	
@@ -419,7 +426,7 @@ void IfElseStmtNode::to3AC(Procedure * proc){
 	elseNop->addLabel(elseLbl);
 	proc->addQuad(elseNop);
 
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		stmt->to3AC(proc);
 	}
 
@@ -438,7 +445,7 @@ void WhileStmtNode::to3AC(Procedure * proc){
 	Label* exitWhile = proc->makeLabel();
 	Quad* falseCondJump = new JmpIfQuad(condOpd, exitWhile);
 
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->to3AC(proc);
 	}
 
@@ -504,7 +511,7 @@ Opd * IndexNode::flatten(Procedure * proc){
 //We only get to this node if we are in a stmt
 // context (DeclNodes protect descent)
 Opd * IDNode::flatten(Procedure * proc){
-	Opd* sym = proc->getSymOpd(mySymbol);
+	Opd* sym = proc->getSymOpd(myDepth, mySlot);
 	if(sym == NULL){
 		throw new InternalError("null ID sym");
 	}
@@ -4,8 +4,10 @@
 namespace crona{
 
 Procedure::Procedure(IRProgram * prog, std::string name)
-: myProg(prog), myName(name){
+: myProg(prog), myName(name), spliced(false){
 	maxTmp = 0;
+	labelBase = myProg->labelCount();
+	stringBase = myProg->stringCount();
 	enter = new EnterQuad(this);
 	leave = new LeaveQuad(this);
 	bodyQuads = new std::list<Quad *>();
@@ -18,6 +20,14 @@ Procedure::Procedure(IRProgram * prog, std::string name)
 	leave->addLabel(leaveLabel);
 }
 
+Procedure::Procedure(IRProgram * prog, std::string name, std::string text)
+: enter(nullptr), leave(nullptr), leaveLabel(nullptr),
+  myProg(prog), bodyQuads(nullptr), myName(name), maxTmp(0),
+  spliced(true), splicedText(text){
+	labelBase = myProg->labelCount();
+	stringBase = myProg->stringCount();
+}
+
 std::string Procedure::getName(){
 	return myName;
 }
@@ -29,6 +39,7 @@ Label * Procedure::getLeaveLabel(){
 IRProgram * Procedure::getProg(){ return myProg; }
 
 std::string Procedure::toString(bool verbose){
+	if (spliced){ return splicedText; }
 	std::string res = "";
 
 	res += "[BEGIN " + this->getName() + " LOCALS]\n";
@@ -38,9 +49,10 @@ std::string Procedure::toString(bool verbose){
 			+ " bytes)\n";
 	}
 
-	for (auto local : this->locals){
-		res += local.second->getName() + " (local var of "
-			+ std::to_string(local.second->getWidth())
+	for (size_t slot = formals.size(); slot < slots.size(); slot++){
+		SymOpd * local = slots[slot];
+		res += local->getName() + " (local var of "
+			+ std::to_string(local->getWidth())
 			+ " bytes)\n";
 	}
 
@@ -78,29 +90,32 @@ Quad * Procedure::popQuad(){
 	return last;
 }
 
+void Procedure::fillSlot(SemSymbol * sym, SymOpd * opd){
+	uint32_t slot = sym->getSlot();
+	if (slot >= slots.size()){ slots.resize(slot + 1, nullptr); }
+	slots[slot] = opd;
+}
+
 void Procedure::gatherLocal(SemSymbol * sym){
 	size_t width = Opd::width(sym->getDataType());
-	locals[sym] = new SymOpd(sym, width);
+	fillSlot(sym, new SymOpd(sym, width));
 }
 
 void Procedure::gatherFormal(SemSymbol * sym){
 	size_t width = Opd::width(sym->getDataType());
-	formals.push_back(new SymOpd(sym, width));
+	SymOpd * opd = new SymOpd(sym, width);
+	formals.push_back(opd);
+	fillSlot(sym, opd);
 }
 
-SymOpd * Procedure::getSymOpd(SemSymbol * sym){
-	for(auto formalSeek : formals){
-		if (formalSeek->getSym() == sym){
-			return formalSeek;
-		}
+SymOpd * Procedure::getSymOpd(uint32_t depth, uint32_t slot){
+	if (depth == 0){
+		return this->getProg()->getGlobal(slot);
 	}
-
-	auto localFound = locals.find(sym);
-	if (localFound != locals.end()){
-		return localFound->second;
+	if (slot < slots.size()){
+		return slots[slot];
 	}
-	
-	return this->getProg()->getGlobal(sym);
+	return nullptr;
 }
 
 AuxOpd * Procedure::makeTmp(size_t width){
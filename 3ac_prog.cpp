@@ -1,5 +1,6 @@
 #include "3ac.hpp"
 #include "vector"
+#include <sstream>
 #include "type_analysis.hpp"
 
 namespace crona {
@@ -24,12 +25,13 @@ size_t IRProgram::opWidth(ASTNode * node){
 
 Label * IRProgram::makeLabel(){
 	Label * label = new Label("lbl_" + std::to_string(max_label++));
+	labels.push_back(label);
 	return label;
 }
 
-SymOpd * IRProgram::getGlobal(SemSymbol * sym){
-	if (globals.find(sym) != globals.end()){
-		return globals[sym];
+SymOpd * IRProgram::getGlobal(uint32_t slot){
+	if (slot < globals.size()){
+		return globals[slot];
 	} 
 	return nullptr;
 }
@@ -37,25 +39,171 @@ SymOpd * IRProgram::getGlobal(SemSymbol * sym){
 void IRProgram::gatherGlobal(SemSymbol * sym){
 	size_t width = Opd::width(sym->getDataType());
 	SymOpd * res = new SymOpd(sym, width);
-	globals[sym] = res;
+	uint32_t slot = sym->getSlot();
+	if (slot >= globals.size()){ globals.resize(slot + 1, nullptr); }
+	globals[slot] = res;
 }
 
 Opd * IRProgram::makeString(std::string val){
 	std::string name = "str_" + std::to_string(str_idx++);
 	AddrOpd * opd = new AddrOpd(name, 1);
 	strings[opd] = val;
+	stringOpds.push_back(opd);
 	return opd;
 }
 
+static void badTemplate(){
+	throw new InternalError("Bad procedure template");
+}
+
+//Replace the label and string placeholders of a template 
+// with names numbered from the given bases. Throws if a
+// placeholder is malformed or names a label or string that
+// the template does not have.
+static std::string renumber(const std::string& line,
+	const ProcTemplate * tmpl, size_t labelBase, size_t stringBase
+){
+	std::string res = "";
+	size_t pos = 0;
+	while (pos < line.size()){
+		size_t open = line.find('\x01', pos);
+		if (open == std::string::npos){
+			res += line.substr(pos);
+			break;
+		}
+		size_t close = line.find('\x01', open + 1);
+		if (close == std::string::npos || close < open + 3){ badTemplate(); }
+		res += line.substr(pos, open - pos);
+		char kind = line[open + 1];
+		size_t limit = kind == 'L' ? tmpl->labelCount : tmpl->strings.size();
+		if (kind != 'L' && kind != 'S'){ badTemplate(); }
+		size_t idx = 0;
+		for (size_t i = open + 2; i < close; i++){
+			if (line[i] < '0' || line[i] > '9'){ badTemplate(); }
+			idx = idx * 10 + static_cast<size_t>(line[i] - '0');
+			if (idx >= limit){ badTemplate(); }
+		}
+		if (kind == 'L'){
+			res += "lbl_" + std::to_string(labelBase + idx);
+		} else {
+			res += "str_" + std::to_string(stringBase + idx);
+		}
+		pos = close + 1;
+	}
+	return res;
+}
+
+//The text of a template's procedure, with its labels and
+// strings numbered from the given bases
+static std::string render(const ProcTemplate * tmpl,
+	size_t labelBase, size_t stringBase
+){
+	std::string text = "";
+	std::istringstream lines(tmpl->body);
+	std::string line;
+	while (std::getline(lines, line)){
+		if (line.size() > 0 && line[0] == '\x01'){
+			//The quad's label column is sized to fit the 
+			// label names, so it has to be laid out again
+			size_t colon = line.find(": ");
+			if (colon == std::string::npos){ badTemplate(); }
+			size_t quadStart = line.find_first_not_of(' ', colon + 1);
+			std::string labelText = renumber(line.substr(0, colon),
+				tmpl, labelBase, stringBase);
+			text += Quad::labelColumn(labelText);
+			if (quadStart != std::string::npos){
+				text += renumber(line.substr(quadStart),
+					tmpl, labelBase, stringBase);
+			}
+		} else {
+			text += renumber(line, tmpl, labelBase, stringBase);
+		}
+		text += "\n";
+	}
+	return text;
+}
+
+bool ProcTemplate::wellFormed() const{
+	try {
+		render(this, 0, 0);
+	} catch (InternalError * e){
+		delete e;
+		return false;
+	}
+	return true;
+}
+
+ProcTemplate * IRProgram::makeTemplate(Procedure * proc){
+	//A procedure's labels and strings run up to wherever 
+	// the next procedure's start
+	size_t labelEnd = max_label;
+	size_t stringEnd = str_idx;
+	bool seen = false;
+	for (Procedure * other : *procs){
+		if (seen){
+			labelEnd = other->getLabelBase();
+			stringEnd = other->getStringBase();
+			break;
+		}
+		seen = (other == proc);
+	}
+
+	size_t labelBase = proc->getLabelBase();
+	size_t stringBase = proc->getStringBase();
+	ProcTemplate * res = new ProcTemplate(proc->getName());
+	res->labelCount = labelEnd - labelBase;
+	for (size_t i = labelBase; i < labelEnd; i++){
+		labels[i]->setName(ProcTemplate::placeholder('L', i - labelBase));
+	}
+	for (size_t i = stringBase; i < stringEnd; i++){
+		AddrOpd * opd = stringOpds[i];
+		res->strings.push_back(strings[opd]);
+		opd->setName(ProcTemplate::placeholder('S', i - stringBase));
+	}
+
+	res->body = proc->toString();
+
+	for (size_t i = labelBase; i < labelEnd; i++){
+		labels[i]->setName("lbl_" + std::to_string(i));
+	}
+	for (size_t i = stringBase; i < stringEnd; i++){
+		stringOpds[i]->setName("str_" + std::to_string(i));
+	}
+	return res;
+}
+
+Procedure * IRProgram::instantiate(const ProcTemplate * tmpl){
+	size_t labelBase = max_label;
+	size_t stringBase = str_idx;
+	Procedure * proc = nullptr;
+
+	std::string text = render(tmpl, labelBase, stringBase);
+
+	proc = new Procedure(this, tmpl->name, text);
+	procs->push_back(proc);
+
+	//Claim the label and string numbers the template uses,
+	// so that later procedures don't reuse them
+	for (size_t i = 0; i < tmpl->labelCount; i++){
+		makeLabel();
+	}
+	for (const std::string& str : tmpl->strings){
+		makeString(str);
+	}
+	return proc;
+}
+
 std::string IRProgram::toString(bool verbose){
 	std::string res = "";
 	res += "[BEGIN GLOBALS]\n";
-	for (auto entry : globals){
-		res += entry.second->getName() + "\n"; 
+	//Globals, locals and strings are all listed in the order
+	// they were made, not in the order of their addresses
+	for (auto opd : globals){
+		res += opd->getName() + "\n"; 
 	}
-	for (auto entry : strings){
-		res += entry.first->locString();
-		res += " " + entry.second; 
+	for (auto opd : stringOpds){
+		res += opd->locString();
+		res += " " + strings[opd]; 
 		res += "\n";
 	}
 
@@ -69,8 +217,8 @@ std::string IRProgram::toString(bool verbose){
 
 std::set<Opd *> IRProgram::globalSyms(){
 	std::set<Opd *> result;
-	for (auto gItr : globals){
-		result.insert(gItr.second);
+	for (auto opd : globals){
+		result.insert(opd);
 	}
 	return result;
 }
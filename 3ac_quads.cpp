@@ -23,19 +23,10 @@ std::string Quad::commentStr(){
 	return "";
 }
 
-std::string Quad::toString(bool verbose){
-	auto res = std::string("");
-
-	auto first = true;
-
+std::string Quad::labelColumn(const std::string& labelText){
 	size_t labelSpace = 12;
-	for (auto label : labels){
-		if (first){ first = false; }
-		else { res += ","; }
-
-		res += label->toString();
-	}
-	if (!first){ res += ": "; }
+	std::string res = labelText;
+	if (labelText.length() > 0){ res += ": "; }
 	else { res += "  "; }
 	size_t spaces;
 	if (res.length() > labelSpace){ spaces = 0; }
@@ -43,6 +34,21 @@ std::string Quad::toString(bool verbose){
 	for (size_t i = 0; i < spaces; i++){
 		res += " ";
 	}
+	return res;
+}
+
+std::string Quad::toString(bool verbose){
+	auto labelText = std::string("");
+
+	auto first = true;
+
+	for (auto label : labels){
+		if (first){ first = false; }
+		else { labelText += ","; }
+
+		labelText += label->toString();
+	}
+	auto res = labelColumn(labelText);
 
 	res += this->repr();
 	if (verbose){
@@ -0,0 +1,60 @@
+#include <cstdint>
+#include "arena.hpp"
+
+namespace crona{
+
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+Arena::Arena() : pos(nullptr), left(0), myUsed(0){
+}
+
+Arena::~Arena(){
+	//Later objects may refer to earlier ones, so tear down
+	// in reverse
+	for (auto itr = finalizers.rbegin(); itr != finalizers.rend(); ++itr){
+		itr->second(itr->first);
+	}
+	for (char * chunk : chunks){
+		delete[] chunk;
+	}
+}
+
+void * Arena::allocate(size_t size, size_t align){
+	uintptr_t addr = reinterpret_cast<uintptr_t>(pos);
+	size_t padding = (align - addr % align) % align;
+	if (pos == nullptr || padding + size > left){
+		//Oversized requests get a chunk of their own
+		size_t chunkSize = CHUNK_SIZE;
+		if (size + align > chunkSize){ chunkSize = size + align; }
+		pos = new char[chunkSize];
+		chunks.push_back(pos);
+		left = chunkSize;
+		addr = reinterpret_cast<uintptr_t>(pos);
+		padding = (align - addr % align) % align;
+	}
+	char * res = pos + padding;
+	pos += padding + size;
+	left -= padding + size;
+	myUsed += size;
+	return res;
+}
+
+void Arena::adopt(Arena * other){
+	chunks.insert(chunks.end(), other->chunks.begin(), other->chunks.end());
+	finalizers.insert(finalizers.end(), other->finalizers.begin(),
+		other->finalizers.end());
+	myUsed += other->myUsed;
+	other->chunks.clear();
+	other->finalizers.clear();
+	other->pos = nullptr;
+	other->left = 0;
+	other->myUsed = 0;
+}
+
+void * Arena::allocateCurrent(size_t size){
+	Arena * arena = active();
+	if (arena == nullptr){ return ::operator new(size); }
+	return arena->allocate(size);
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef CRONA_ARENA_HPP
+#define CRONA_ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace crona{
+
+//A bump-pointer allocator that owns everything allocated
+// from it, all of which is released at once when the arena
+// is destroyed. Each CompilationSession has one, which
+// holds its tokens, AST nodes and the AST's child lists.
+//
+// Tokens and AST nodes are allocated from the arena that is
+// active on the current thread (their classes override
+// operator new to call allocateCurrent()), so the parser
+// and type analysis can keep using plain `new`. With no
+// arena active, they come from the heap as usual.
+class Arena{
+public:
+	Arena();
+	~Arena();
+
+	void * allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+	//Construct a T in the arena. If T has a destructor that
+	// does something, it is run when the arena goes away.
+	template <typename T, typename... Args>
+	T * make(Args&&... args){
+		void * mem = allocate(sizeof(T), alignof(T));
+		T * obj = new (mem) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value){
+			finalizers.push_back(Finalizer(obj, &destroy<T>));
+		}
+		return obj;
+	}
+
+	//Bytes handed out so far
+	size_t used() const { return myUsed; }
+
+	//Take over everything allocated from other, which is
+	// left empty, so that it lives as long as this arena
+	// does. Lets threads fill arenas of their own and hand
+	// the results to one owner.
+	void adopt(Arena * other);
+
+	static Arena * active(){ return current(); }
+	static void activate(Arena * arena){ current() = arena; }
+
+	//Allocate from the active arena, or the heap if there
+	// is none
+	static void * allocateCurrent(size_t size);
+	//Construct a T in the active arena, or on the heap if
+	// there is none
+	template <typename T, typename... Args>
+	static T * makeCurrent(Args&&... args){
+		Arena * arena = active();
+		if (arena == nullptr){ return new T(std::forward<Args>(args)...); }
+		return arena->make<T>(std::forward<Args>(args)...);
+	}
+private:
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	template <typename T>
+	static void destroy(void * obj){
+		static_cast<T *>(obj)->~T();
+	}
+
+	typedef std::pair<void *, void (*)(void *)> Finalizer;
+
+	static Arena *& current(){
+		thread_local Arena * arena = nullptr;
+		return arena;
+	}
+
+	std::vector<char *> chunks;
+	char * pos;
+	size_t left;
+	size_t myUsed;
+	std::vector<Finalizer> finalizers;
+};
+
+//Makes an arena the active one for as long as it is in
+// scope
+class ArenaScope{
+public:
+	ArenaScope(Arena * arena) : saved(Arena::active()){
+		Arena::activate(arena);
+	}
+	~ArenaScope(){ Arena::activate(saved); }
+private:
+	Arena * saved;
+};
+
+}
+
+#endif
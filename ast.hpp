@@ -4,7 +4,10 @@
 #include <ostream>
 #include <sstream>
 #include <string.h>
-#include <list>
+#include <vector>
+#include "flat_ast.hpp"
+#include "source_buffer.hpp"
+#include "span.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 #include "3ac.hpp"
@@ -12,6 +15,7 @@
 namespace crona {
 
 class TypeAnalysis;
+class TokenBuffer;
 
 class Opd;
 
@@ -19,6 +23,7 @@ class SymbolTable;
 class SemSymbol;
 
 class DeclNode;
+class FnDeclNode;
 class VarDeclNode;
 class StmtNode;
 class AssignExpNode;
@@ -30,40 +35,67 @@ class IDNode;
 
 class ASTNode{
 public:
-	ASTNode(size_t lineIn, size_t colIn)
-	: l(lineIn), c(colIn){ }
+	//offsetIn is where the node starts in the source
+	ASTNode(uint32_t offsetIn)
+	: mySrcOffset(offsetIn), myDataType(nullptr){ }
+	//Nodes live in the compilation's Arena, and are freed
+	// along with it
+	static void * operator new(size_t size){
+		return Arena::allocateCurrent(size);
+	}
+	static void operator delete(void *){ }
 	virtual void unparse(std::ostream&, int) = 0;
-	size_t line() const { return this->l; }
-	size_t col() const { return this->c; }
+	uint32_t offset() const { return mySrcOffset; }
+	//Looked up in the active SourceBuffer
+	size_t line() const { return SourceBuffer::locate(mySrcOffset).line; }
+	size_t col() const { return SourceBuffer::locate(mySrcOffset).col; }
 	std::string pos(){
-		return "[" + std::to_string(line()) + ","
-			+ std::to_string(col()) + "]";
+		LineCol where = SourceBuffer::locate(mySrcOffset);
+		return "[" + std::to_string(where.line) + ","
+			+ std::to_string(where.col) + "]";
 	}
 	virtual bool nameAnalysis(SymbolTable *) = 0;
+	//Append this subtree to a FlatAST
+	virtual void toFlat(FlatAST * flat) = 0;
 	//Note that there is no ASTNode::typeAnalysis. To allow
 	// for different type signatures, type analysis is 
 	// implemented as needed in various subclasses
+	//The type given to the node by type analysis (see
+	// TypeAnalysis::nodeType), or nullptr before it
+	const DataType * dataType() const { return myDataType; }
+	void setDataType(const DataType * type){ myDataType = type; }
 private:
-	size_t l;
-	size_t c;
+	uint32_t mySrcOffset;
+	const DataType * myDataType;
 };
 
 class ProgramNode : public ASTNode{
 public:
-	ProgramNode(std::list<DeclNode *> * globalsIn)
-	: ASTNode(1,1), myGlobals(globalsIn){}
+	ProgramNode(Span<DeclNode *> globalsIn)
+	: ASTNode(0), myGlobals(globalsIn){}
 	void unparse(std::ostream&, int) override;
+	void toFlat(FlatAST * flat) override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
 	IRProgram * to3AC(TypeAnalysis * ta);
+	Span<DeclNode *> getGlobals(){ return myGlobals; }
+	//Defer the body of each function, in order, to the
+	// next declaration of tokens in decls (the start and
+	// end index of each, as found by TokenSlice)
+	void deferBodies(const TokenBuffer * tokens,
+		const std::vector<std::pair<size_t, size_t>>& decls);
+	//Parse every deferred function body. Returns false at
+	// the first one with a syntax error, with stoppedAt set
+	// to where in the source the parser stopped.
+	bool parseBodies(size_t& stoppedAt);
 	virtual ~ProgramNode(){ }
 private:
-	std::list<DeclNode *> * myGlobals;
+	Span<DeclNode *> myGlobals;
 };
 
 class ExpNode : public ASTNode{
 protected:
-	ExpNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
+	ExpNode(uint32_t offset) : ASTNode(offset){ }
 public:
 	virtual void unparseNested(std::ostream& out);
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
@@ -73,7 +105,7 @@ public:
 
 class LValNode : public ExpNode{
 public:
-	LValNode(size_t lIn, size_t cIn) : ExpNode(lIn, cIn){}
+	LValNode(uint32_t offset) : ExpNode(offset){}
 	void unparse(std::ostream& out, int indent) override = 0;
 	void unparseNested(std::ostream& out) override;
 	void attachSymbol(SemSymbol * symbolIn) { } 
@@ -84,25 +116,37 @@ public:
 
 class IDNode : public LValNode{
 public:
-	IDNode(size_t lIn, size_t cIn, std::string nameIn)
-	: LValNode(lIn, cIn), name(nameIn), mySymbol(nullptr){}
-	std::string getName(){ return name; }
+	IDNode(uint32_t offset, StrRef nameIn, uint32_t nameIDIn)
+	: LValNode(offset), name(nameIn), nameID(nameIDIn), 
+	  mySymbol(nullptr), myDepth(0), mySlot(0){}
+	StrRef getName(){ return name; }
+	//The name's key in the Interner
+	uint32_t getNameID(){ return nameID; }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
+	//Also takes the symbol's depth and slot, so that later
+	// phases can index by them without going through it
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol() const { return mySymbol; }
+	uint32_t getDepth() const { return myDepth; }
+	uint32_t getSlot() const { return mySlot; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
 private:
-	std::string name;
+	StrRef name;
+	uint32_t nameID;
 	SemSymbol * mySymbol;
+	uint32_t myDepth;
+	uint32_t mySlot;
 };
 
 class IndexNode : public LValNode{
 public:
-	IndexNode(size_t l, size_t c, IDNode * id, ExpNode * offset)
-	: LValNode(l, c), myBase(id), myOffset(offset){ }
+	IndexNode(uint32_t offset, IDNode * id, ExpNode * index)
+	: LValNode(offset), myBase(id), myOffset(index){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -114,7 +158,7 @@ private:
 
 class TypeNode : public ASTNode{
 public:
-	TypeNode(size_t l, size_t c) : ASTNode(l, c){ }
+	TypeNode(uint32_t offset) : ASTNode(offset){ }
 	void unparse(std::ostream&, int) override = 0;
 	virtual DataType * getType() = 0;
 	virtual bool nameAnalysis(SymbolTable *) override;
@@ -123,7 +167,7 @@ public:
 
 class StmtNode : public ASTNode{
 public:
-	StmtNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
+	StmtNode(uint32_t offset) : ASTNode(offset){ }
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) = 0;
 	virtual void to3AC(Procedure * proc) = 0;
@@ -131,18 +175,20 @@ public:
 
 class DeclNode : public StmtNode{
 public:
-	DeclNode(size_t l, size_t c) : StmtNode(l, c){ }
+	DeclNode(uint32_t offset) : StmtNode(offset){ }
 	void unparse(std::ostream& out, int indent) override =0;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
 	virtual void to3AC(IRProgram * prog) = 0;
 	virtual void to3AC(Procedure * proc) override = 0;
+	virtual FnDeclNode * asFnDecl(){ return nullptr; }
 };
 
 class VarDeclNode : public DeclNode{
 public:
-	VarDeclNode(size_t lIn, size_t cIn, TypeNode * typeIn, IDNode * IDIn)
-	: DeclNode(lIn, cIn), myType(typeIn), myID(IDIn){ }
+	VarDeclNode(uint32_t offset, TypeNode * typeIn, IDNode * IDIn)
+	: DeclNode(offset), myType(typeIn), myID(IDIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	IDNode * ID(){ return myID; }
 	TypeNode * getTypeNode(){ return myType; }
 	bool nameAnalysis(SymbolTable * symTab) override;
@@ -156,46 +202,82 @@ private:
 
 class FormalDeclNode : public VarDeclNode{
 public:
-	FormalDeclNode(size_t lIn, size_t cIn, TypeNode * type, IDNode * id) 
-	: VarDeclNode(lIn, cIn, type, id){ }
+	FormalDeclNode(uint32_t offset, TypeNode * type, IDNode * id) 
+	: VarDeclNode(offset, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void to3AC(Procedure * proc) override;
 	virtual void to3AC(IRProgram * prog) override;
 };
 
 class FnDeclNode : public DeclNode{
 public:
-	FnDeclNode(size_t lIn, size_t cIn, 
+	FnDeclNode(uint32_t offset, 
 	  IDNode * idIn, TypeNode * retTypeIn,
-	  std::list<FormalDeclNode *> * formalsIn,
-	  std::list<StmtNode *> * bodyIn)
-	: DeclNode(lIn, cIn), 
+	  Span<FormalDeclNode *> formalsIn,
+	  Span<StmtNode *> bodyIn)
+	: DeclNode(offset), 
 	  myID(idIn), myRetType(retTypeIn),
-	  myFormals(formalsIn), myBody(bodyIn){ }
+	  myFormals(formalsIn), myBody(bodyIn),
+	  myTemplate(nullptr), myBodyTokens(nullptr),
+	  myBodyFrom(0), myBodyTo(0), myBodyOK(true){ }
 	IDNode * ID() const { return myID; }
-	std::list<FormalDeclNode *> * getFormals() const{
+	Span<FormalDeclNode *> getFormals() const{
 		return myFormals;
 	}
-	void unparse(std::ostream& out, int indent) override;
+	//The body's statements, parsed now if they were
+	// deferred (an empty list if they fail to parse)
+	Span<StmtNode *> body(){
+		parseBody();
+		return myBody;
+	}
+	//Leave the body to be parsed when it is first asked for,
+	// from this function's whole declaration: tokens from
+	// index from up to to
+	void deferBody(const TokenBuffer * tokens, size_t from, size_t to);
+	//Parse the body into the active arena if it was deferred
+	// and hasn't been yet. Returns false (having reported
+	// the error) if it has a syntax error, with stoppedAt,
+	// if given, set to where in the source the parser stopped.
+	bool parseBody(size_t * stoppedAt = nullptr);
+	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
+	//Unparse just the name, return type and formals
+	void unparseSignature(std::ostream& out);
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
+	//nameAnalysis in two parts: binding the function's name
+	// (in the current scope), then its formals and body (in
+	// a scope of their own)
+	bool nameSignature(SymbolTable * symTab);
+	bool nameBody(SymbolTable * symTab);
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	void to3AC(IRProgram * prog) override;
 	void to3AC(Procedure * prog) override;
 	virtual TypeNode * getRetTypeNode() { 
 		return myRetType;
 	}
+	FnDeclNode * asFnDecl() override { return this; }
+	//Use an earlier compilation's 3AC for this function
+	// (see ProcCache) in place of checking and lowering it
+	void useTemplate(const ProcTemplate * tmpl){ myTemplate = tmpl; }
 private:
 	IDNode * myID;
 	TypeNode * myRetType;
-	std::list<FormalDeclNode *> * myFormals;
-	std::list<StmtNode *> * myBody;
+	Span<FormalDeclNode *> myFormals;
+	Span<StmtNode *> myBody;
+	const ProcTemplate * myTemplate;
+	const TokenBuffer * myBodyTokens;
+	uint32_t myBodyFrom;
+	uint32_t myBodyTo;
+	bool myBodyOK;
 };
 
 class AssignStmtNode : public StmtNode{
 public:
-	AssignStmtNode(size_t l, size_t c, AssignExpNode * expIn)
-	: StmtNode(l, c), myExp(expIn){ }
+	AssignStmtNode(uint32_t offset, AssignExpNode * expIn)
+	: StmtNode(offset), myExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
@@ -205,9 +287,10 @@ private:
 
 class ReadStmtNode : public StmtNode{
 public:
-	ReadStmtNode(size_t l, size_t c, LValNode * dstIn)
-	: StmtNode(l, c), myDst(dstIn){ }
+	ReadStmtNode(uint32_t offset, LValNode * dstIn)
+	: StmtNode(offset), myDst(dstIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
@@ -217,9 +300,10 @@ private:
 
 class WriteStmtNode : public StmtNode{
 public:
-	WriteStmtNode(size_t l, size_t c, ExpNode * srcIn)
-	: StmtNode(l, c), mySrc(srcIn){ }
+	WriteStmtNode(uint32_t offset, ExpNode * srcIn)
+	: StmtNode(offset), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
@@ -229,9 +313,10 @@ private:
 
 class PostDecStmtNode : public StmtNode{
 public:
-	PostDecStmtNode(size_t l, size_t c, LValNode * lvalIn)
-	: StmtNode(l, c), myLVal(lvalIn){ }
+	PostDecStmtNode(uint32_t offset, LValNode * lvalIn)
+	: StmtNode(offset), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
@@ -241,9 +326,10 @@ private:
 
 class PostIncStmtNode : public StmtNode{
 public:
-	PostIncStmtNode(size_t l, size_t c, LValNode * lvalIn)
-	: StmtNode(l, c), myLVal(lvalIn){ }
+	PostIncStmtNode(uint32_t offset, LValNode * lvalIn)
+	: StmtNode(offset), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
@@ -253,54 +339,58 @@ private:
 
 class IfStmtNode : public StmtNode{
 public:
-	IfStmtNode(size_t l, size_t c, ExpNode * condIn,
-	  std::list<StmtNode *> * bodyIn)
-	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	IfStmtNode(uint32_t offset, ExpNode * condIn,
+	  Span<StmtNode *> bodyIn)
+	: StmtNode(offset), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	Span<StmtNode *> myBody;
 };
 
 class IfElseStmtNode : public StmtNode{
 public:
-	IfElseStmtNode(size_t l, size_t c, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyTrueIn,
-	  std::list<StmtNode *> * bodyFalseIn)
-	: StmtNode(l, c), myCond(condIn),
+	IfElseStmtNode(uint32_t offset, ExpNode * condIn, 
+	  Span<StmtNode *> bodyTrueIn,
+	  Span<StmtNode *> bodyFalseIn)
+	: StmtNode(offset), myCond(condIn),
 	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBodyTrue;
-	std::list<StmtNode *> * myBodyFalse;
+	Span<StmtNode *> myBodyTrue;
+	Span<StmtNode *> myBodyFalse;
 };
 
 class WhileStmtNode : public StmtNode{
 public:
-	WhileStmtNode(size_t l, size_t c, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyIn)
-	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	WhileStmtNode(uint32_t offset, ExpNode * condIn, 
+	  Span<StmtNode *> bodyIn)
+	: StmtNode(offset), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * prog) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	Span<StmtNode *> myBody;
 };
 
 class ReturnStmtNode : public StmtNode{
 public:
-	ReturnStmtNode(size_t l, size_t c, ExpNode * exp)
-	: StmtNode(l, c), myExp(exp){ }
+	ReturnStmtNode(uint32_t offset, ExpNode * exp)
+	: StmtNode(offset), myExp(exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * proc) override;
@@ -310,10 +400,11 @@ private:
 
 class CallExpNode : public ExpNode{
 public:
-	CallExpNode(size_t l, size_t c, IDNode * id,
-	  std::list<ExpNode *> * argsIn)
-	: ExpNode(l, c), myID(id), myArgs(argsIn){ }
+	CallExpNode(uint32_t offset, IDNode * id,
+	  Span<ExpNode *> argsIn)
+	: ExpNode(offset), myID(id), myArgs(argsIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	void unparseNested(std::ostream& out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
@@ -322,13 +413,13 @@ public:
 	virtual Opd * flatten(Procedure * proc) override;
 private:
 	IDNode * myID;
-	std::list<ExpNode *> * myArgs;
+	Span<ExpNode *> myArgs;
 };
 
 class BinaryExpNode : public ExpNode{
 public:
-	BinaryExpNode(size_t lIn, size_t cIn, ExpNode * lhs, ExpNode * rhs)
-	: ExpNode(lIn, cIn), myExp1(lhs), myExp2(rhs) { }
+	BinaryExpNode(uint32_t offset, ExpNode * lhs, ExpNode * rhs)
+	: ExpNode(offset), myExp1(lhs), myExp2(rhs) { }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
 	virtual Opd * flatten(Procedure * prog) override = 0;
@@ -338,68 +429,76 @@ protected:
 	void binaryLogicTyping(TypeAnalysis * typing);
 	void binaryEqTyping(TypeAnalysis * typing);
 	void binaryRelTyping(TypeAnalysis * typing);
+	void binaryToFlat(FlatAST * flat, FlatAST::Kind kind);
 	void binaryMathTyping(TypeAnalysis * typing);
 };
 
 class PlusNode : public BinaryExpNode{
 public:
-	PlusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	PlusNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class MinusNode : public BinaryExpNode{
 public:
-	MinusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	MinusNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class TimesNode : public BinaryExpNode{
 public:
-	TimesNode(size_t l, size_t c, ExpNode * e1In, ExpNode * e2In)
-	: BinaryExpNode(l, c, e1In, e2In){ }
+	TimesNode(uint32_t offset, ExpNode * e1In, ExpNode * e2In)
+	: BinaryExpNode(offset, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class DivideNode : public BinaryExpNode{
 public:
-	DivideNode(size_t lIn, size_t cIn, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(lIn, cIn, e1, e2){ }
+	DivideNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class AndNode : public BinaryExpNode{
 public:
-	AndNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	AndNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class OrNode : public BinaryExpNode{
 public:
-	OrNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	OrNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class EqualsNode : public BinaryExpNode{
 public:
-	EqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	EqualsNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 	
@@ -407,9 +506,10 @@ public:
 
 class NotEqualsNode : public BinaryExpNode{
 public:
-	NotEqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	NotEqualsNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 	
@@ -417,46 +517,50 @@ public:
 
 class LessNode : public BinaryExpNode{
 public:
-	LessNode(size_t lineIn, size_t colIn, 
+	LessNode(uint32_t offset, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(offset, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
 };
 
 class LessEqNode : public BinaryExpNode{
 public:
-	LessEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	LessEqNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class GreaterNode : public BinaryExpNode{
 public:
-	GreaterNode(size_t lineIn, size_t colIn, 
+	GreaterNode(uint32_t offset, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(offset, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
 };
 
 class GreaterEqNode : public BinaryExpNode{
 public:
-	GreaterEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
-	: BinaryExpNode(l, c, e1, e2){ }
+	GreaterEqNode(uint32_t offset, ExpNode * e1, ExpNode * e2)
+	: BinaryExpNode(offset, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
 };
 
 class UnaryExpNode : public ExpNode {
 public:
-	UnaryExpNode(size_t lIn, size_t cIn, ExpNode * expIn) 
-	: ExpNode(lIn, cIn){
+	UnaryExpNode(uint32_t offset, ExpNode * expIn) 
+	: ExpNode(offset){
 		this->myExp = expIn;
 	}
 	virtual void unparse(std::ostream& out, int indent) override = 0;
@@ -469,9 +573,10 @@ protected:
 
 class NegNode : public UnaryExpNode{
 public:
-	NegNode(size_t l, size_t c, ExpNode * exp)
-	: UnaryExpNode(l, c, exp){ }
+	NegNode(uint32_t offset, ExpNode * exp)
+	: UnaryExpNode(offset, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -479,9 +584,10 @@ public:
 
 class NotNode : public UnaryExpNode{
 public:
-	NotNode(size_t lIn, size_t cIn, ExpNode * exp)
-	: UnaryExpNode(lIn, cIn, exp){ }
+	NotNode(uint32_t offset, ExpNode * exp)
+	: UnaryExpNode(offset, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -489,8 +595,9 @@ public:
 
 class VoidTypeNode : public TypeNode{
 public:
-	VoidTypeNode(size_t l, size_t c) : TypeNode(l, c){}
+	VoidTypeNode(uint32_t offset) : TypeNode(offset){}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual DataType * getType()override { 
 		return BasicType::VOID(); 
 	}
@@ -498,29 +605,33 @@ public:
 
 class IntTypeNode : public TypeNode{
 public:
-	IntTypeNode(size_t l, size_t c): TypeNode(l, c){}
+	IntTypeNode(uint32_t offset): TypeNode(offset){}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual DataType * getType() override;
 };
 
 class BoolTypeNode : public TypeNode{
 public:
-	BoolTypeNode(size_t l, size_t c): TypeNode(l, c) { }
+	BoolTypeNode(uint32_t offset): TypeNode(offset) { }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual DataType * getType() override;
 };
 
 class ByteTypeNode : public TypeNode{
 public:
-	ByteTypeNode(size_t l, size_t c): TypeNode(l, c) { }
+	ByteTypeNode(uint32_t offset): TypeNode(offset) { }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual DataType * getType() override;
 };
 
 class ArrayTypeNode : public TypeNode{
 public:
-	ArrayTypeNode(size_t l, size_t c, TypeNode * base, size_t len): TypeNode(l, c), myLen(len), myBase(base){}
+	ArrayTypeNode(uint32_t offset, TypeNode * base, size_t len): TypeNode(offset), myLen(len), myBase(base){}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	virtual DataType * getType() override { 
 		const BasicType * t = myBase->getType()->asBasic();
 		return ArrayType::produce(t, myLen); 
@@ -533,9 +644,10 @@ private:
 
 class AssignExpNode : public ExpNode{
 public:
-	AssignExpNode(size_t l, size_t c, LValNode * dstIn, ExpNode * srcIn)
-	: ExpNode(l, c), myDst(dstIn), mySrc(srcIn){ }
+	AssignExpNode(uint32_t offset, LValNode * dstIn, ExpNode * srcIn)
+	: ExpNode(offset), myDst(dstIn), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
@@ -546,12 +658,13 @@ private:
 
 class IntLitNode : public ExpNode{
 public:
-	IntLitNode(size_t l, size_t c, const int numIn)
-	: ExpNode(l, c), myNum(numIn){ }
+	IntLitNode(uint32_t offset, const int numIn)
+	: ExpNode(offset), myNum(numIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -562,13 +675,14 @@ private:
 class ByteToIntNode : public ExpNode{
 public:
 	ByteToIntNode(ExpNode * child)
-	: ExpNode(child->line(), child->col()), myChild(child){ }
+	: ExpNode(child->offset()), myChild(child){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override{
 		myChild->unparse(out, indent);
 	}
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override { return true; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -578,12 +692,13 @@ private:
 
 class HavocNode : public ExpNode{
 public:
-	HavocNode(size_t l, size_t c)
-	: ExpNode(l, c){ }
+	HavocNode(uint32_t offset)
+	: ExpNode(offset){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
@@ -591,26 +706,28 @@ public:
 
 class StrLitNode : public ExpNode{
 public:
-	StrLitNode(size_t l, size_t c, const std::string strIn)
-	: ExpNode(l, c), myStr(strIn){ }
+	StrLitNode(uint32_t offset, StrRef strIn)
+	: ExpNode(offset), myStr(strIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * proc) override;
 private:
-	 const std::string myStr;
+	 const StrRef myStr;
 };
 
 class TrueNode : public ExpNode{
 public:
-	TrueNode(size_t l, size_t c): ExpNode(l, c){ }
+	TrueNode(uint32_t offset): ExpNode(offset){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -618,11 +735,12 @@ public:
 
 class FalseNode : public ExpNode{
 public:
-	FalseNode(size_t l, size_t c): ExpNode(l, c){ }
+	FalseNode(uint32_t offset): ExpNode(offset){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual Opd * flatten(Procedure * prog) override;
@@ -630,9 +748,10 @@ public:
 
 class CallStmtNode : public StmtNode{
 public:
-	CallStmtNode(size_t l, size_t c, CallExpNode * expIn)
-	: StmtNode(l, c), myCallExp(expIn){ }
+	CallStmtNode(uint32_t offset, CallExpNode * expIn)
+	: StmtNode(offset), myCallExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	void toFlat(FlatAST * flat) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	virtual void to3AC(Procedure * proc) override;
@@ -0,0 +1,506 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "ast_cache.hpp"
+#include "errors.hpp"
+#include "interner.hpp"
+#include "proc_cache.hpp"
+
+namespace crona{
+
+static const char MAGIC[8] = { 'C', 'R', 'A', 'S', 'T', 0, 0, 0 };
+//Bump this whenever FlatAST's kinds or layouts change, so
+// that stale entries are never used
+static const uint32_t VERSION = 2;
+//Entries are written in the machine's own byte order, and
+// only read back on a machine with the same one
+static const uint32_t ENDIAN_CHECK = 0x01020304;
+
+class CacheHeader{
+public:
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t sourceSize;
+	uint32_t nodeCount;
+	uint32_t stringCount;
+	uint32_t nameCount;
+	uint32_t textSize;
+	uint32_t messageSize;
+	//ProcCache::digest of everything after the header, so
+	// that an entry damaged on disk is not taken for a
+	// good one
+	char digest[32];
+};
+
+//Where each part of an entry starts, in bytes from the
+// start of the file
+class CacheLayout{
+public:
+	CacheLayout(const CacheHeader& header){
+		uint64_t nodes = header.nodeCount;
+		kinds = sizeof(CacheHeader);
+		offsets = kinds + (nodes + 3) / 4 * 4;
+		ends = offsets + 4 * nodes;
+		payloads = ends + 4 * nodes;
+		strings = payloads + 4 * nodes;
+		names = strings + 8 * static_cast<uint64_t>(header.stringCount);
+		text = names + 8 * static_cast<uint64_t>(header.nameCount);
+		messages = text + header.textSize;
+		size = messages + header.messageSize;
+	}
+	uint64_t kinds;
+	uint64_t offsets;
+	uint64_t ends;
+	uint64_t payloads;
+	uint64_t strings;
+	uint64_t names;
+	uint64_t text;
+	uint64_t messages;
+	uint64_t size;
+};
+
+static std::string entryPath(const std::string& dir,
+	const SourceBuffer * source
+){
+	return dir + "/"
+		+ ProcCache::digest(source->data(), source->size()) + ".ast";
+}
+
+static void badCache(const char * why){
+	std::string msg = "Bad AST cache: ";
+	msg += why;
+	throw new InternalError(msg.c_str());
+}
+
+static void writeWords(std::ostream& out, const std::vector<uint32_t>& words){
+	out.write(reinterpret_cast<const char *>(words.data()),
+		static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+}
+
+//Add text to the table of (start, length) pairs
+static void addText(std::vector<uint32_t>& table, std::string& text,
+	StrRef str
+){
+	table.push_back(static_cast<uint32_t>(text.size()));
+	table.push_back(static_cast<uint32_t>(str.size()));
+	text.append(str.data(), str.size());
+}
+
+void ASTCache::save(const std::string& dir, const SourceBuffer * source,
+	const FlatAST * flat, const std::string& messages
+){
+	uint32_t count = static_cast<uint32_t>(flat->size());
+	std::vector<uint8_t> kinds(count);
+	std::vector<uint32_t> offsets(count);
+	std::vector<uint32_t> ends(count);
+	std::vector<uint32_t> payloads(count);
+	std::vector<uint32_t> strings;
+	std::vector<uint32_t> names;
+	std::string text;
+	//Each distinct identifier, by Interner ID, is stored once
+	std::unordered_map<uint32_t, uint32_t> nameIndex;
+	for (uint32_t node = 0; node < count; node++){
+		FlatAST::Kind kind = flat->kind(node);
+		kinds[node] = kind;
+		offsets[node] = flat->offset(node);
+		ends[node] = flat->end(node);
+		payloads[node] = flat->payload(node);
+		if (kind == FlatAST::STR_LIT){
+			payloads[node] = static_cast<uint32_t>(strings.size() / 2);
+			addText(strings, text, flat->string(node));
+		} else if (kind == FlatAST::ID){
+			uint32_t next = static_cast<uint32_t>(names.size() / 2);
+			auto found = nameIndex.emplace(flat->payload(node), next);
+			if (found.second){ addText(names, text, flat->name(node)); }
+			payloads[node] = found.first->second;
+		}
+	}
+	if (text.size() > UINT32_MAX || messages.size() > UINT32_MAX){ return; }
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrder = ENDIAN_CHECK;
+	header.sourceSize = static_cast<uint32_t>(source->size());
+	header.nodeCount = count;
+	header.stringCount = static_cast<uint32_t>(strings.size() / 2);
+	header.nameCount = static_cast<uint32_t>(names.size() / 2);
+	header.textSize = static_cast<uint32_t>(text.size());
+	header.messageSize = static_cast<uint32_t>(messages.size());
+	kinds.resize((kinds.size() + 3) / 4 * 4, 0);
+
+	//Write to a private file and rename it into place, so
+	// that concurrent compilations never see a half-written
+	// entry
+	if (!ProcCache::makeDirs(dir)){ return; }
+	std::string path = entryPath(dir, source);
+	std::string tmpPath = path + ".XXXXXX";
+	int fd = mkstemp(&tmpPath[0]);
+	if (fd < 0){ return; }
+	close(fd);
+
+	std::ostringstream body;
+	body.write(reinterpret_cast<const char *>(kinds.data()),
+		static_cast<std::streamsize>(kinds.size()));
+	writeWords(body, offsets);
+	writeWords(body, ends);
+	writeWords(body, payloads);
+	writeWords(body, strings);
+	writeWords(body, names);
+	body.write(text.data(), static_cast<std::streamsize>(text.size()));
+	body.write(messages.data(),
+		static_cast<std::streamsize>(messages.size()));
+	std::string bytes = body.str();
+	std::string digest = ProcCache::digest(bytes.data(), bytes.size());
+	memcpy(header.digest, digest.data(), sizeof(header.digest));
+
+	std::ofstream out(tmpPath, std::ios::binary);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	out.close();
+	if (!out.good() || rename(tmpPath.c_str(), path.c_str()) != 0){
+		unlink(tmpPath.c_str());
+	}
+}
+
+//Rebuilds the ASTNode tree from an entry, in place in the
+// mapped file
+class TreeLoader{
+public:
+	TreeLoader(const char * base, const CacheHeader& header,
+		Arena * textArena);
+	ProgramNode * program();
+private:
+	FlatAST::Kind kind(uint32_t node) const {
+		return static_cast<FlatAST::Kind>(kinds[node]);
+	}
+	uint32_t offset(uint32_t node) const { return offsets[node]; }
+	uint32_t payload(uint32_t node) const { return payloads[node]; }
+	//The child of parent after node (or parent's first
+	// child, for node == parent)
+	uint32_t next(uint32_t parent, uint32_t node) const {
+		uint32_t res = node == parent ? parent + 1 : ends[node];
+		if (res >= ends[parent]){ badCache("missing child"); }
+		return res;
+	}
+	//Parent's children from node on, as statements
+	Span<StmtNode *> stmts(uint32_t parent, uint32_t node, uint32_t to);
+
+	DeclNode * decl(uint32_t node);
+	VarDeclNode * varDecl(uint32_t node);
+	StmtNode * stmt(uint32_t node);
+	ExpNode * exp(uint32_t node);
+	LValNode * lval(uint32_t node);
+	IDNode * id(uint32_t node);
+	AssignExpNode * assign(uint32_t node);
+	CallExpNode * call(uint32_t node);
+	TypeNode * type(uint32_t node);
+
+	uint32_t count;
+	const uint8_t * kinds;
+	const uint32_t * offsets;
+	const uint32_t * ends;
+	const uint32_t * payloads;
+	std::vector<StrRef> strings;
+	std::vector<StrRef> names;
+	std::vector<uint32_t> nameIDs;
+};
+
+TreeLoader::TreeLoader(const char * base, const CacheHeader& header,
+	Arena * textArena
+)
+: count(header.nodeCount){
+	CacheLayout at(header);
+	kinds = reinterpret_cast<const uint8_t *>(base + at.kinds);
+	offsets = reinterpret_cast<const uint32_t *>(base + at.offsets);
+	ends = reinterpret_cast<const uint32_t *>(base + at.ends);
+	payloads = reinterpret_cast<const uint32_t *>(base + at.payloads);
+	for (uint32_t node = 0; node < count; node++){
+		if (kinds[node] > FlatAST::ARRAY_TYPE){ badCache("bad kind"); }
+		if (ends[node] <= node || ends[node] > count){
+			badCache("bad subtree");
+		}
+		if (header.sourceSize > 0 && offsets[node] >= header.sourceSize){
+			badCache("node past the end");
+		}
+	}
+
+	//The text outlives the mapping
+	char * text = static_cast<char *>(
+		textArena->allocate(header.textSize, 1));
+	memcpy(text, base + at.text, header.textSize);
+	const uint32_t * table = reinterpret_cast<const uint32_t *>(
+		base + at.strings);
+	uint32_t tableSize = header.stringCount + header.nameCount;
+	for (uint32_t i = 0; i < tableSize; i++){
+		uint64_t start = table[2 * i];
+		uint64_t len = table[2 * i + 1];
+		if (start + len > header.textSize){ badCache("bad text"); }
+		StrRef str(text + start, static_cast<size_t>(len));
+		if (i < header.stringCount){
+			strings.push_back(str);
+		} else {
+			names.push_back(str);
+			nameIDs.push_back(Interner::global().intern(str));
+		}
+	}
+}
+
+ProgramNode * TreeLoader::program(){
+	if (count == 0 || kind(0) != FlatAST::PROGRAM){
+		badCache("no program");
+	}
+	SpanBuilder<DeclNode *> globals;
+	for (uint32_t node = 1; node < ends[0]; node = ends[node]){
+		globals.push_back(decl(node));
+	}
+	return new ProgramNode(globals.finish());
+}
+
+Span<StmtNode *> TreeLoader::stmts(uint32_t parent, uint32_t node,
+	uint32_t to
+){
+	SpanBuilder<StmtNode *> res;
+	for (; node < to; node = ends[node]){
+		if (ends[node] > ends[parent]){ badCache("bad subtree"); }
+		res.push_back(stmt(node));
+	}
+	return res.finish();
+}
+
+DeclNode * TreeLoader::decl(uint32_t node){
+	if (kind(node) == FlatAST::VAR_DECL){ return varDecl(node); }
+	if (kind(node) != FlatAST::FN_DECL){ badCache("bad declaration"); }
+
+	uint32_t at = next(node, node);
+	IDNode * name = id(at);
+	at = next(node, at);
+	TypeNode * retType = type(at);
+	SpanBuilder<FormalDeclNode *> formals;
+	for (uint32_t i = 0; i < payload(node); i++){
+		at = next(node, at);
+		if (kind(at) != FlatAST::FORMAL_DECL){ badCache("bad formal"); }
+		uint32_t formalType = next(at, at);
+		uint32_t formalID = next(at, formalType);
+		formals.push_back(new FormalDeclNode(offset(at), type(formalType),
+			id(formalID)));
+	}
+	Span<StmtNode *> body = stmts(node, ends[at], ends[node]);
+	return new FnDeclNode(offset(node), name, retType, formals.finish(),
+		body);
+}
+
+VarDeclNode * TreeLoader::varDecl(uint32_t node){
+	uint32_t typeAt = next(node, node);
+	uint32_t idAt = next(node, typeAt);
+	return new VarDeclNode(offset(node), type(typeAt), id(idAt));
+}
+
+StmtNode * TreeLoader::stmt(uint32_t node){
+	uint32_t first = node + 1;
+	switch (kind(node)){
+	case FlatAST::VAR_DECL:
+		return varDecl(node);
+	case FlatAST::ASSIGN_STMT:
+		return new AssignStmtNode(offset(node), assign(next(node, node)));
+	case FlatAST::READ_STMT:
+		return new ReadStmtNode(offset(node), lval(next(node, node)));
+	case FlatAST::WRITE_STMT:
+		return new WriteStmtNode(offset(node), exp(next(node, node)));
+	case FlatAST::POST_DEC_STMT:
+		return new PostDecStmtNode(offset(node), lval(next(node, node)));
+	case FlatAST::POST_INC_STMT:
+		return new PostIncStmtNode(offset(node), lval(next(node, node)));
+	case FlatAST::IF_STMT: {
+		ExpNode * cond = exp(next(node, node));
+		return new IfStmtNode(offset(node), cond,
+			stmts(node, ends[first], ends[node]));
+	}
+	case FlatAST::IF_ELSE_STMT: {
+		ExpNode * cond = exp(next(node, node));
+		//The false branch starts after payload statements
+		uint32_t split = ends[first];
+		for (uint32_t i = 0; i < payload(node); i++){
+			if (split >= ends[node]){ badCache("missing child"); }
+			split = ends[split];
+		}
+		Span<StmtNode *> bodyTrue = stmts(node, ends[first], split);
+		Span<StmtNode *> bodyFalse = stmts(node, split, ends[node]);
+		return new IfElseStmtNode(offset(node), cond, bodyTrue, bodyFalse);
+	}
+	case FlatAST::WHILE_STMT: {
+		ExpNode * cond = exp(next(node, node));
+		return new WhileStmtNode(offset(node), cond,
+			stmts(node, ends[first], ends[node]));
+	}
+	case FlatAST::RETURN_STMT: {
+		ExpNode * val = first < ends[node] ? exp(first) : nullptr;
+		return new ReturnStmtNode(offset(node), val);
+	}
+	case FlatAST::CALL_STMT:
+		return new CallStmtNode(offset(node), call(next(node, node)));
+	default:
+		badCache("bad statement");
+		return nullptr;
+	}
+}
+
+ExpNode * TreeLoader::exp(uint32_t node){
+	uint32_t off = offset(node);
+	switch (kind(node)){
+	case FlatAST::ID:
+	case FlatAST::INDEX:
+		return lval(node);
+	case FlatAST::CALL:
+		return call(node);
+	case FlatAST::INT_LIT:
+		return new IntLitNode(off, static_cast<int>(payload(node)));
+	case FlatAST::STR_LIT:
+		if (payload(node) >= strings.size()){ badCache("bad string"); }
+		return new StrLitNode(off, strings[payload(node)]);
+	case FlatAST::TRUE:
+		return new TrueNode(off);
+	case FlatAST::FALSE:
+		return new FalseNode(off);
+	case FlatAST::HAVOC:
+		return new HavocNode(off);
+	case FlatAST::NEG:
+		return new NegNode(off, exp(next(node, node)));
+	case FlatAST::NOT:
+		return new NotNode(off, exp(next(node, node)));
+	case FlatAST::ASSIGN:
+		return assign(node);
+	default:
+		break;
+	}
+
+	uint32_t lhs = next(node, node);
+	uint32_t rhs = next(node, lhs);
+	ExpNode * e1 = exp(lhs);
+	ExpNode * e2 = exp(rhs);
+	switch (kind(node)){
+	case FlatAST::PLUS: return new PlusNode(off, e1, e2);
+	case FlatAST::MINUS: return new MinusNode(off, e1, e2);
+	case FlatAST::TIMES: return new TimesNode(off, e1, e2);
+	case FlatAST::DIVIDE: return new DivideNode(off, e1, e2);
+	case FlatAST::AND: return new AndNode(off, e1, e2);
+	case FlatAST::OR: return new OrNode(off, e1, e2);
+	case FlatAST::EQUALS: return new EqualsNode(off, e1, e2);
+	case FlatAST::NOT_EQUALS: return new NotEqualsNode(off, e1, e2);
+	case FlatAST::LESS: return new LessNode(off, e1, e2);
+	case FlatAST::LESS_EQ: return new LessEqNode(off, e1, e2);
+	case FlatAST::GREATER: return new GreaterNode(off, e1, e2);
+	case FlatAST::GREATER_EQ: return new GreaterEqNode(off, e1, e2);
+	default:
+		badCache("bad expression");
+		return nullptr;
+	}
+}
+
+LValNode * TreeLoader::lval(uint32_t node){
+	if (kind(node) == FlatAST::ID){ return id(node); }
+	if (kind(node) != FlatAST::INDEX){ badCache("bad lvalue"); }
+	uint32_t base = next(node, node);
+	uint32_t index = next(node, base);
+	return new IndexNode(offset(node), id(base), exp(index));
+}
+
+AssignExpNode * TreeLoader::assign(uint32_t node){
+	if (kind(node) != FlatAST::ASSIGN){ badCache("bad assignment"); }
+	uint32_t dst = next(node, node);
+	uint32_t src = next(node, dst);
+	return new AssignExpNode(offset(node), lval(dst), exp(src));
+}
+
+IDNode * TreeLoader::id(uint32_t node){
+	if (kind(node) != FlatAST::ID || payload(node) >= names.size()){
+		badCache("bad identifier");
+	}
+	return new IDNode(offset(node), names[payload(node)],
+		nameIDs[payload(node)]);
+}
+
+CallExpNode * TreeLoader::call(uint32_t node){
+	if (kind(node) != FlatAST::CALL){ badCache("bad call"); }
+	uint32_t callee = next(node, node);
+	IDNode * name = id(callee);
+	SpanBuilder<ExpNode *> args;
+	for (uint32_t arg = ends[callee]; arg < ends[node]; arg = ends[arg]){
+		if (ends[arg] > ends[node]){ badCache("bad subtree"); }
+		args.push_back(exp(arg));
+	}
+	return new CallExpNode(offset(node), name, args.finish());
+}
+
+TypeNode * TreeLoader::type(uint32_t node){
+	uint32_t off = offset(node);
+	switch (kind(node)){
+	case FlatAST::VOID_TYPE: return new VoidTypeNode(off);
+	case FlatAST::INT_TYPE: return new IntTypeNode(off);
+	case FlatAST::BOOL_TYPE: return new BoolTypeNode(off);
+	case FlatAST::BYTE_TYPE: return new ByteTypeNode(off);
+	case FlatAST::ARRAY_TYPE:
+		return new ArrayTypeNode(off, type(next(node, node)), payload(node));
+	default:
+		badCache("bad type");
+		return nullptr;
+	}
+}
+
+ProgramNode * ASTCache::load(const std::string& dir,
+	const SourceBuffer * source, Arena * textArena
+){
+	std::string path = entryPath(dir, source);
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0){ return nullptr; }
+
+	SourceBuffer * file = SourceBuffer::map(path.c_str());
+	CacheHeader header;
+	if (file->size() < sizeof(header)){
+		delete file;
+		return nullptr;
+	}
+	memcpy(&header, file->data(), sizeof(header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+	  || header.version != VERSION || header.byteOrder != ENDIAN_CHECK
+	  || header.sourceSize != source->size()){
+		delete file;
+		return nullptr;
+	}
+
+	ProgramNode * root = nullptr;
+	try {
+		if (CacheLayout(header).size != file->size()){
+			badCache("wrong size");
+		}
+		std::string digest = ProcCache::digest(file->data() + sizeof(header),
+			file->size() - sizeof(header));
+		if (memcmp(digest.data(), header.digest, sizeof(header.digest)) != 0){
+			badCache("wrong digest");
+		}
+		TreeLoader loader(file->data(), header, textArena);
+		root = loader.program();
+	} catch (InternalError * e){
+		//A damaged entry is a miss, and is removed so that the
+		// next save can replace it. What was loaded of it is
+		// left in the arenas, unused.
+		delete e;
+		delete file;
+		unlink(path.c_str());
+		return nullptr;
+	}
+	CacheLayout at(header);
+	Report::emitLines(std::string(file->data() + at.messages,
+		header.messageSize));
+	delete file;
+	return root;
+}
+
+}
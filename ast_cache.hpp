@@ -0,0 +1,47 @@
+#ifndef CRONA_AST_CACHE_HPP
+#define CRONA_AST_CACHE_HPP
+
+#include <string>
+#include "ast.hpp"
+#include "flat_ast.hpp"
+#include "source_buffer.hpp"
+
+namespace crona{
+
+//An on-disk cache of parsed ASTs, so that a file that goes
+// through cronac several times is only scanned and parsed
+// the first time. The entry for a source is the file
+// <dir>/<hash of the source>.ast, so an entry is never used
+// for text other than the text it was parsed from.
+//
+// An entry is a FlatAST laid out to be mapped and read in
+// place: a fixed header (with a digest of the rest, checked
+// on load), then the node arrays (kinds, offsets, ends and
+// payloads, each 4-byte aligned), a table of (start,
+// length) pairs for the string literals and another for
+// the identifiers, the text they point into, and the
+// scanner's messages. Every position in the file
+// is relative to its start. An ID node's payload is its
+// name's index in the identifier table, not an Interner
+// ID, which would only mean something to the process that
+// wrote it.
+class ASTCache{
+public:
+	//Write the entry for source, holding flat and the
+	// messages the scanner reported for it
+	static void save(const std::string& dir, const SourceBuffer * source,
+		const FlatAST * flat, const std::string& messages);
+	//The AST in the entry for source, rebuilt in the active
+	// arena, or nullptr if there is no (current) entry. The
+	// text of its identifiers and string literals goes in
+	// textArena (as scanned text goes with the tokens, which
+	// may outlive the tree). The scanner's messages are
+	// reported again, as if it had run. A malformed entry is
+	// removed and treated as a miss.
+	static ProgramNode * load(const std::string& dir,
+		const SourceBuffer * source, Arena * textArena);
+};
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include <fstream>
+#include <sstream>
+#include "batch.hpp"
+#include "driver.hpp"
+#include "errors.hpp"
+#include "session.hpp"
+#include "time_report.hpp"
+#include "worker_pool.hpp"
+
+namespace crona{
+
+struct BatchResult{
+	BatchResult() : ok(false){ }
+	bool ok;
+	std::string out;
+	std::string err;
+};
+
+static std::string outputPath(const std::string& inPath){
+	std::string suffix = ".crona";
+	if (inPath.size() > suffix.size()){
+		size_t stemLen = inPath.size() - suffix.size();
+		if (inPath.compare(stemLen, suffix.size(), suffix) == 0){
+			return inPath.substr(0, stemLen) + ".3ac";
+		}
+	}
+	return inPath + ".3ac";
+}
+
+static bool compileOne(const std::string& inPath, const char * cacheDir){
+	try {
+		CompilationSession session(inPath.c_str());
+		ProcCache * cache = nullptr;
+		if (cacheDir != nullptr){
+			cache = new ProcCache(cacheDir);
+			session.setCache(cache);
+		}
+		IRProgram * prog = session.ir();
+		delete cache;
+		if (prog == nullptr){ return false; }
+
+		std::string outPath = outputPath(inPath);
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			Report::emit("Bad output file " + outPath);
+			return false;
+		}
+		outStream << prog->toString() << std::endl;
+		return true;
+	} catch (ToDoError * e){
+		Report::emit(std::string("ToDoError: ") + e->msg());
+	} catch (InternalError * e){
+		Report::emit("InternalError: " + e->msg());
+	}
+	return false;
+}
+
+//Prefix every line of a diagnostic block with the input
+// it came from, so that blocks stay readable in a CI log
+static void printPrefixed(std::ostream& out,
+	const std::string& prefix, const std::string& text
+){
+	std::istringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line)){
+		out << prefix << ": " << line << "\n";
+	}
+}
+
+bool BatchCompiler::readManifest(const std::string& path,
+	std::vector<std::string>& inputs
+){
+	std::ifstream manifest(path);
+	if (!manifest.good()){ return false; }
+	std::string line;
+	while (std::getline(manifest, line)){
+		if (line.empty()){ continue; }
+		inputs.push_back(line);
+	}
+	return true;
+}
+
+int BatchCompiler::run(const std::vector<std::string>& args){
+	std::vector<std::string> inputs;
+	size_t threads = 0;
+	std::string cacheDirStr;
+	const char * cacheDir = nullptr;
+	std::string tracePath;
+	for (size_t i = 0; i < args.size(); i++){
+		const std::string& arg = args[i];
+		if (arg == "--cache"){
+			cacheDirStr = ProcCache::defaultDir();
+			cacheDir = cacheDirStr.c_str();
+		} else if (arg == "--cache-dir"){
+			i++;
+			if (i >= args.size()){
+				std::cerr << "--cache-dir needs a directory\n";
+				return 1;
+			}
+			cacheDirStr = args[i];
+			cacheDir = cacheDirStr.c_str();
+		} else if (arg == "--trace-out"){
+			i++;
+			if (i >= args.size()){
+				std::cerr << "--trace-out needs a file\n";
+				return 1;
+			}
+			tracePath = args[i];
+		} else if (arg == "-j"){
+			i++;
+			if (i >= args.size()){
+				std::cerr << "-j needs a thread count\n";
+				return 1;
+			}
+			if (!DriverOptions::threadCount(args[i].c_str(), threads,
+				std::cerr)){
+				return 1;
+			}
+		} else if (arg[0] == '@'){
+			if (!readManifest(arg.substr(1), inputs)){
+				std::cerr << "Bad manifest " << arg.substr(1) << "\n";
+				return 1;
+			}
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty()){
+		std::cerr << "No inputs given for --batch\n";
+		return 1;
+	}
+
+	//One trace for the whole batch, so that the spans of
+	// each worker thread can be seen side by side
+	Tracer * tracer = nullptr;
+	if (!tracePath.empty()){ tracer = new Tracer(); }
+
+	std::vector<BatchResult> results(inputs.size());
+	{
+		WorkerPool pool(threads);
+		for (size_t i = 0; i < inputs.size(); i++){
+			pool.submit([&inputs, &results, cacheDir, tracer, i](){
+				std::ostringstream out;
+				std::ostringstream err;
+				Report::redirect(&err, &out);
+				Tracer::activate(tracer);
+				{
+					PhaseTimer timer(inputs[i].c_str());
+					results[i].ok = compileOne(inputs[i], cacheDir);
+				}
+				Tracer::activate(nullptr);
+				Report::restore();
+				results[i].out = out.str();
+				results[i].err = err.str();
+			});
+		}
+		pool.wait();
+	}
+
+	size_t passed = 0;
+	for (size_t i = 0; i < inputs.size(); i++){
+		printPrefixed(std::cout, inputs[i], results[i].out);
+		printPrefixed(std::cerr, inputs[i], results[i].err);
+		if (results[i].ok){ passed++; }
+	}
+	std::cerr << passed << " of " << inputs.size()
+		<< " inputs compiled\n";
+
+	if (tracer != nullptr){
+		std::ofstream traceStream(tracePath);
+		if (!traceStream.good()){
+			std::cerr << "Bad output file " << tracePath << "\n";
+			delete tracer;
+			return 1;
+		}
+		tracer->write(traceStream);
+		delete tracer;
+	}
+
+	if (passed == inputs.size()){ return 0; }
+	return 1;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef CRONA_BATCH_HPP
+#define CRONA_BATCH_HPP
+
+#include <string>
+#include <vector>
+
+namespace crona{
+
+//Compile many inputs in one process. Each input X.crona is
+// compiled all the way to 3AC, which is written to X.3ac
+// (the same thing `cronac X.crona -a X.3ac` does). Inputs
+// are spread over a WorkerPool; diagnostics for each input
+// are collected separately and printed in input order once
+// everything is done.
+class BatchCompiler{
+public:
+	//args are the command-line arguments following --batch.
+	// An argument of the form @path names a manifest file
+	// holding one input path per line. "-j N" sets the
+	// number of worker threads (default: one per core).
+	// "--cache" or "--cache-dir D" turns on the per-function
+	// 3AC cache (see ProcCache). "--trace-out F" writes a
+	// Chrome trace of every worker thread to F.
+	// Returns the process exit code: 0 if every input
+	// compiled, 1 otherwise.
+	static int run(const std::vector<std::string>& args);
+private:
+	static bool readManifest(const std::string& path,
+		std::vector<std::string>& inputs);
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+//Time spent walking an already-built AST, as an ASTNode
+// tree and as a FlatAST: repeated unparses (into a stream
+// that throws the text away) and repeated name analyses of
+// a synthetic program. Also compares how much memory the
+// two encodings take (the tree's includes the type slot of
+// every node and the symbol slot of every identifier).
+//
+// Only walks of trees that are already built are timed, so
+// the scanner does not figure in the times. Which encoding
+// walks faster does depend on the optimization level: at
+// -O0 the FlatAST's array accessors are calls, not inlined.
+#include <iostream>
+#include <streambuf>
+#include "bench_util.hpp"
+#include "errors.hpp"
+#include "name_analysis.hpp"
+#include "session.hpp"
+
+using namespace crona;
+
+class NullBuf : public std::streambuf{
+protected:
+	std::streamsize xsputn(const char *, std::streamsize n) override{
+		return n;
+	}
+	int overflow(int c) override{ return c; }
+};
+
+int main(int argc, char ** argv){
+	size_t fns = 2000;
+	size_t reps = 20;
+	if (argc > 1){ fns = std::stoul(argv[1]); }
+	if (argc > 2){ reps = std::stoul(argv[2]); }
+	std::string source = bench::syntheticProgram(fns);
+	double perRep = static_cast<double>(reps);
+
+	CompilationSession session("synthetic.crona", source);
+	session.tokens();
+	size_t beforeParse = session.arenaBytes();
+	ProgramNode * ast = session.ast();
+	size_t treeBytes = session.arenaBytes() - beforeParse;
+	CompilationSession flatSession("synthetic.crona", source);
+	FlatAST * flat = flatSession.flatAST();
+	if (ast == nullptr || flat == nullptr){
+		std::cerr << "synthetic program did not parse\n";
+		return 1;
+	}
+
+	//The flat form gains a symbol slot per node once named
+	size_t flatBytes = flat->bytes();
+
+	NullBuf nullBuf;
+	std::ostream nullOut(&nullBuf);
+	//Tree and flat walks alternate, so that both see the
+	// same heap (name analysis leaves its symbols behind)
+	double unparseMs = 0;
+	double flatUnparseMs = 0;
+	double nameMs = 0;
+	double flatNameMs = 0;
+	for (size_t i = 0; i < reps; i++){
+		auto start = std::chrono::steady_clock::now();
+		ast->unparse(nullOut, 0);
+		unparseMs += bench::millisSince(start);
+
+		start = std::chrono::steady_clock::now();
+		flat->unparse(nullOut);
+		flatUnparseMs += bench::millisSince(start);
+
+		start = std::chrono::steady_clock::now();
+		auto names = crona::NameAnalysis::build(ast);
+		nameMs += bench::millisSince(start);
+
+		start = std::chrono::steady_clock::now();
+		bool flatNamed = flat->nameAnalysis();
+		flatNameMs += bench::millisSince(start);
+
+		if (names == nullptr || !flatNamed){
+			std::cerr << "synthetic program failed name analysis\n";
+			return 1;
+		}
+		delete names;
+	}
+
+	double nodes = static_cast<double>(flat->size());
+	std::cout << "functions:      " << fns << "\n";
+	std::cout << "nodes:          " << flat->size() << "\n";
+	std::cout << "tree:           " << static_cast<double>(treeBytes) / nodes
+		<< " bytes/node\n";
+	std::cout << "flat:           " << static_cast<double>(flatBytes) / nodes
+		<< " bytes/node parsed, "
+		<< static_cast<double>(flat->bytes()) / nodes
+		<< " bytes/node named\n";
+	std::cout << "unparse:        " << unparseMs / perRep
+		<< " ms/walk tree, " << flatUnparseMs / perRep << " ms/walk flat\n";
+	std::cout << "name analysis:  " << nameMs / perRep
+		<< " ms/walk tree, " << flatNameMs / perRep << " ms/walk flat\n";
+	return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef CRONA_BENCH_UTIL_HPP
+#define CRONA_BENCH_UTIL_HPP
+
+#include <chrono>
+#include <string>
+
+namespace crona{
+namespace bench{
+
+//A well-typed program with fns functions, each using a mix
+// of declarations, arithmetic, calls, branches, loops and
+// string literals, so that every phase has work to do
+inline std::string syntheticProgram(size_t fns){
+	std::string res = "counter:int;\nflags:bool array[8];\n";
+	for (size_t i = 0; i < fns; i++){
+		std::string n = std::to_string(i);
+		res += "fn_" + n + ":int(alpha_" + n + ":int, beta:int, on:bool){\n";
+		res += "\tlocal_sum:int;\n\tlocal_idx:int;\n\tbuf:byte array[16];\n";
+		res += "\tlocal_sum = alpha_" + n + " * 3 + beta - 7;\n";
+		res += "\tlocal_idx = 0;\n";
+		res += "\twhile (local_idx < 10){\n";
+		res += "\t\tif (on && local_sum > beta){\n";
+		res += "\t\t\tlocal_sum = local_sum - local_idx / 2;\n";
+		res += "\t\t} else {\n";
+		res += "\t\t\tlocal_sum = local_sum + 1;\n";
+		res += "\t\t\twrite \"else branch " + n + "\";\n";
+		res += "\t\t}\n";
+		res += "\t\tlocal_idx++;\n";
+		res += "\t}\n";
+		res += "\tcounter = counter + local_sum;\n";
+		if (i > 0){
+			res += "\tlocal_sum = fn_" + std::to_string(i - 1)
+				+ "(local_sum, beta, !on);\n";
+		}
+		res += "\treturn local_sum;\n}\n";
+	}
+	res += "main:void(){\n\tcounter = 0;\n";
+	if (fns > 0){
+		res += "\twrite fn_" + std::to_string(fns - 1) + "(1, 2, true);\n";
+	}
+	res += "\twrite counter;\n}\n";
+	return res;
+}
+
+inline double millisSince(std::chrono::steady_clock::time_point start){
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+}
+}
+
+#endif
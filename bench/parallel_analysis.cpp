@@ -0,0 +1,62 @@
+//Name and type analysis of the synthetic program with
+// function bodies analyzed on 1 (the sequential analyses),
+// 2, 4 and as many threads as there are cores. Reports the
+// time per analysis for each.
+//
+// The program is parsed once, before anything is timed. With
+// fewer cores than threads, the extra threads can only add
+// the cost of snapshots, forks and merging to the sequential
+// time, so run it on a machine with at least four cores.
+#include <iostream>
+#include "bench_util.hpp"
+#include "name_analysis.hpp"
+#include "session.hpp"
+#include "type_analysis.hpp"
+#include "worker_pool.hpp"
+
+using namespace crona;
+
+int main(int argc, char ** argv){
+	size_t fns = 20000;
+	size_t reps = 5;
+	if (argc > 1){ fns = std::stoul(argv[1]); }
+	if (argc > 2){ reps = std::stoul(argv[2]); }
+	double perRep = static_cast<double>(reps);
+
+	CompilationSession session("synthetic.crona",
+		bench::syntheticProgram(fns));
+	ProgramNode * ast = session.ast();
+	if (ast == nullptr){
+		std::cerr << "synthetic program did not parse\n";
+		return 1;
+	}
+	Arena arena;
+	ArenaScope arenaScope(&arena);
+
+	const size_t threadCounts[] = { 1, 2, 4, WorkerPool::defaultSize() };
+	for (size_t threads : threadCounts){
+		double nameMs = 0;
+		double typeMs = 0;
+		for (size_t i = 0; i < reps; i++){
+			auto start = std::chrono::steady_clock::now();
+			auto names = crona::NameAnalysis::build(ast, threads);
+			nameMs += bench::millisSince(start);
+			if (names == nullptr){
+				std::cerr << "synthetic program failed name analysis\n";
+				return 1;
+			}
+			start = std::chrono::steady_clock::now();
+			TypeAnalysis * types = TypeAnalysis::build(names, threads);
+			typeMs += bench::millisSince(start);
+			if (types == nullptr){
+				std::cerr << "synthetic program failed type analysis\n";
+				return 1;
+			}
+			delete types;
+			delete names;
+		}
+		std::cout << threads << " thread(s): names " << nameMs / perRep
+			<< " ms, types " << typeMs / perRep << " ms\n";
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+//Parsing throughput, in tokens per second, of the bison
+// Parser and of the hand-written RDParser over the tokens of
+// the same synthetic program. Also checks that the two build
+// the same AST (by comparing their unparses).
+//
+// The tokens come from a FastScanner before any parser is
+// timed, so the lexer a build was made with makes no odds.
+// The parsers themselves run at the optimization level of
+// the compiler's objects, and the gap between them narrows
+// a good deal once those are built with -O2.
+#include <iostream>
+#include <sstream>
+#include "bench_util.hpp"
+#include "fast_scanner.hpp"
+#include "rd_parser.hpp"
+
+using namespace crona;
+
+static ProgramNode * bisonParse(const TokenBuffer * tokens){
+	ProgramNode * root = nullptr;
+	TokenSlice slice(tokens, 0, tokens->size());
+	Parser parser(slice, &root);
+	if (parser.parse() != 0){ return nullptr; }
+	return root;
+}
+
+static ProgramNode * rdParse(const TokenBuffer * tokens){
+	RDParser parser(tokens, 0, tokens->size());
+	return parser.parse();
+}
+
+int main(int argc, char ** argv){
+	size_t fns = 2000;
+	size_t reps = 10;
+	if (argc > 1){ fns = std::stoul(argv[1]); }
+	if (argc > 2){ reps = std::stoul(argv[2]); }
+	SourceBuffer * source = SourceBuffer::copy(bench::syntheticProgram(fns));
+	SourceScope sourceScope(source);
+	Arena tokenArena;
+	ArenaScope tokenScope(&tokenArena);
+	TokenBuffer tokens;
+	FastScanner scanner(source);
+	scanner.fill(&tokens);
+
+	std::ostringstream bisonText;
+	std::ostringstream rdText;
+	{
+		Arena arena;
+		ArenaScope arenaScope(&arena);
+		ProgramNode * bisonRoot = bisonParse(&tokens);
+		ProgramNode * rdRoot = rdParse(&tokens);
+		if (bisonRoot == nullptr || rdRoot == nullptr){
+			std::cerr << "synthetic program did not parse\n";
+			return 1;
+		}
+		bisonRoot->unparse(bisonText, 0);
+		rdRoot->unparse(rdText, 0);
+	}
+	if (bisonText.str() != rdText.str()){
+		std::cerr << "the parsers' ASTs differ\n";
+		return 1;
+	}
+
+	//The two parsers take turns, so that both see the same
+	// state of the machine
+	double bisonMs = 0;
+	double rdMs = 0;
+	for (size_t i = 0; i < reps; i++){
+		{
+			Arena arena;
+			ArenaScope arenaScope(&arena);
+			auto start = std::chrono::steady_clock::now();
+			bisonParse(&tokens);
+			bisonMs += bench::millisSince(start);
+		}
+		{
+			Arena arena;
+			ArenaScope arenaScope(&arena);
+			auto start = std::chrono::steady_clock::now();
+			rdParse(&tokens);
+			rdMs += bench::millisSince(start);
+		}
+	}
+
+	double mtok = static_cast<double>(tokens.size()) / 1e6;
+	double parsed = mtok * static_cast<double>(reps);
+	std::cout << "tokens:         " << mtok << " M\n";
+	std::cout << "bison:          " << parsed / (bisonMs / 1000)
+		<< " Mtok/s\n";
+	std::cout << "rd:             " << parsed / (rdMs / 1000)
+		<< " Mtok/s\n";
+	delete source;
+	return 0;
+}
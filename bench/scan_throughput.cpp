@@ -0,0 +1,76 @@
+//Scanning throughput, in MB of source per second, of the
+// flex Scanner and of the hand-written FastScanner over the
+// same synthetic program. Also checks that the two produce
+// the same token stream.
+#include <iostream>
+#include <sstream>
+#include "bench_util.hpp"
+#include "fast_scanner.hpp"
+#include "scanner.hpp"
+
+using namespace crona;
+
+int main(int argc, char ** argv){
+	size_t fns = 2000;
+	size_t reps = 10;
+	if (argc > 1){ fns = std::stoul(argv[1]); }
+	if (argc > 2){ reps = std::stoul(argv[2]); }
+	SourceBuffer * source = SourceBuffer::copy(bench::syntheticProgram(fns));
+	SourceScope sourceScope(source);
+
+	std::ostringstream flexTokens;
+	std::ostringstream fastTokens;
+	{
+		Arena arena;
+		ArenaScope arenaScope(&arena);
+		SourceStream inStream(source);
+		Scanner scanner(&inStream, source);
+		scanner.outputTokens(flexTokens);
+	}
+	{
+		Arena arena;
+		ArenaScope arenaScope(&arena);
+		FastScanner scanner(source);
+		scanner.outputTokens(fastTokens);
+	}
+	if (flexTokens.str() != fastTokens.str()){
+		std::cerr << "the scanners' token streams differ\n";
+		return 1;
+	}
+
+	//The two scanners take turns, so that both see the same
+	// state of the machine
+	double flexMs = 0;
+	double fastMs = 0;
+	for (size_t i = 0; i < reps; i++){
+		{
+			Arena arena;
+			ArenaScope arenaScope(&arena);
+			TokenBuffer tokens;
+			auto start = std::chrono::steady_clock::now();
+			SourceStream inStream(source);
+			Scanner scanner(&inStream, source);
+			scanner.fill(&tokens);
+			flexMs += bench::millisSince(start);
+		}
+		{
+			Arena arena;
+			ArenaScope arenaScope(&arena);
+			TokenBuffer tokens;
+			auto start = std::chrono::steady_clock::now();
+			FastScanner scanner(source);
+			scanner.fill(&tokens);
+			fastMs += bench::millisSince(start);
+		}
+	}
+
+	double mb = static_cast<double>(source->size()) / 1e6;
+	double scanned = mb * static_cast<double>(reps);
+	std::cout << "source:         " << mb << " MB\n";
+	std::cout << "flex:           " << scanned / (flexMs / 1000)
+		<< " MB/s\n";
+	std::cout << "fast:           " << scanned / (fastMs / 1000)
+		<< " MB/s\n";
+	delete source;
+	return 0;
+}
@@ -0,0 +1,72 @@
+//Name analysis of deeply nested if/while blocks: each block
+// declares a local and reads names from every few levels
+// out, down to the globals, so that lookups have many scopes
+// to see past. Reports the time per analysis for several
+// nesting depths.
+//
+// Each program is parsed before its analyses are timed, so
+// the times are all symbol table and AST walk. Built at -O0,
+// the walk's share is large enough to hide much of the
+// difference between depths.
+#include <iostream>
+#include "bench_util.hpp"
+#include "name_analysis.hpp"
+#include "session.hpp"
+
+using namespace crona;
+
+//fns functions, each nesting blocks depth deep
+static std::string nestedProgram(size_t fns, size_t depth){
+	std::string res = "g_0:int;\ng_1:bool;\n";
+	for (size_t f = 0; f < fns; f++){
+		res += "fn_" + std::to_string(f) + ":void(p:int){\n";
+		res += "v_0:int;\n";
+		for (size_t d = 1; d <= depth; d++){
+			std::string n = std::to_string(d);
+			std::string up = std::to_string(d / 2);
+			std::string prev = std::to_string(d - 1);
+			res += d % 2 == 0 ? "if (g_1){\n" : "while (g_1){\n";
+			res += "v_" + n + ":int;\n";
+			res += "v_" + n + " = v_" + prev + " + v_" + up
+				+ " + v_0 + p + g_0;\n";
+		}
+		for (size_t d = 1; d <= depth; d++){
+			res += "}\n";
+		}
+		res += "}\n";
+	}
+	return res;
+}
+
+int main(int argc, char ** argv){
+	size_t reps = 20;
+	if (argc > 1){ reps = std::stoul(argv[1]); }
+	double perRep = static_cast<double>(reps);
+
+	const size_t depths[] = { 4, 32, 256, 1024 };
+	for (size_t depth : depths){
+		//About the same number of blocks at every depth
+		size_t fns = 8192 / depth;
+		CompilationSession session("nested.crona",
+			nestedProgram(fns, depth));
+		ProgramNode * ast = session.ast();
+		if (ast == nullptr){
+			std::cerr << "nested program did not parse\n";
+			return 1;
+		}
+		double nameMs = 0;
+		for (size_t i = 0; i < reps; i++){
+			auto start = std::chrono::steady_clock::now();
+			auto names = crona::NameAnalysis::build(ast);
+			nameMs += bench::millisSince(start);
+			if (names == nullptr){
+				std::cerr << "nested program failed name analysis\n";
+				return 1;
+			}
+			delete names;
+		}
+		std::cout << "depth " << depth << ": " << nameMs / perRep << " ms/analysis (" << fns
+			<< " functions)\n";
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+//Heap allocations per token in the front end: scanning,
+// parsing and name analysis of a synthetic program. Every
+// call to the global operator new is counted.
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "bench_util.hpp"
+#include "errors.hpp"
+#include "session.hpp"
+
+static std::atomic<size_t> allocCount(0);
+
+void * operator new(size_t size){
+	allocCount++;
+	void * res = malloc(size == 0 ? 1 : size);
+	if (res == nullptr){ throw std::bad_alloc(); }
+	return res;
+}
+
+void operator delete(void * ptr) noexcept{
+	free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept{
+	free(ptr);
+}
+
+using namespace crona;
+
+int main(int argc, char ** argv){
+	size_t fns = 2000;
+	if (argc > 1){ fns = std::stoul(argv[1]); }
+	std::string source = bench::syntheticProgram(fns);
+
+	CompilationSession session("synthetic.crona", source);
+
+	size_t before = allocCount;
+	auto start = std::chrono::steady_clock::now();
+	TokenBuffer * tokens = session.tokens();
+	double scanMs = bench::millisSince(start);
+	size_t scanAllocs = allocCount - before;
+
+	before = allocCount;
+	start = std::chrono::steady_clock::now();
+	ProgramNode * ast = session.ast();
+	double parseMs = bench::millisSince(start);
+	size_t parseAllocs = allocCount - before;
+
+	before = allocCount;
+	start = std::chrono::steady_clock::now();
+	auto names = session.nameAnalysis();
+	double nameMs = bench::millisSince(start);
+	size_t nameAllocs = allocCount - before;
+
+	if (ast == nullptr || names == nullptr){
+		std::cerr << "synthetic program did not compile\n";
+		return 1;
+	}
+
+	double count = static_cast<double>(tokens->size());
+	std::cout << "tokens:         " << tokens->size() << "\n";
+	std::cout << "scan:           " << scanAllocs / count
+		<< " allocs/token, " << scanMs << " ms\n";
+	std::cout << "parse:          " << parseAllocs / count
+		<< " allocs/token, " << parseMs << " ms\n";
+	std::cout << "name analysis:  " << nameAllocs / count
+		<< " allocs/token, " << nameMs << " ms\n";
+	std::cout << "total:          "
+		<< (scanAllocs + parseAllocs + nameAllocs) / count
+		<< " allocs/token\n";
+	return 0;
+}
@@ -0,0 +1,73 @@
+//Name and type analysis of programs whose functions each
+// have a signature and a local array size of their own, so
+// that there are as many distinct types as functions. Reports
+// the time per analysis for several program sizes: it should
+// grow with the number of types, not with its square.
+//
+// Parsing happens before the clock starts. Types produced by
+// one analysis are still there for the next, so every rep
+// after the first finds its types already interned.
+#include <iostream>
+#include "bench_util.hpp"
+#include "name_analysis.hpp"
+#include "session.hpp"
+#include "type_analysis.hpp"
+
+using namespace crona;
+
+//fns functions, the i'th taking the formals given by i's
+// digits in base 3 and declaring an int array of i + 1
+static std::string distinctTypes(size_t fns){
+	const char * names[] = { "int", "bool", "byte" };
+	std::string res;
+	for (size_t f = 0; f < fns; f++){
+		std::string n = std::to_string(f);
+		res += "fn_" + n + ":void(";
+		size_t digits = f;
+		for (size_t i = 0; i < 10; i++){
+			if (i > 0){ res += ", "; }
+			res += "p_" + std::to_string(i) + ":" + names[digits % 3];
+			digits /= 3;
+		}
+		res += "){\n";
+		res += "arr:int array[" + std::to_string(f + 1) + "];\n";
+		res += "arr[0] = 1;\n";
+		res += "}\n";
+	}
+	return res;
+}
+
+int main(int argc, char ** argv){
+	size_t reps = 5;
+	if (argc > 1){ reps = std::stoul(argv[1]); }
+	double perRep = static_cast<double>(reps);
+
+	const size_t sizes[] = { 1000, 4000, 16000 };
+	for (size_t fns : sizes){
+		CompilationSession session("types.crona", distinctTypes(fns));
+		ProgramNode * ast = session.ast();
+		if (ast == nullptr){
+			std::cerr << "program did not parse\n";
+			return 1;
+		}
+		Arena arena;
+		ArenaScope arenaScope(&arena);
+		double ms = 0;
+		for (size_t i = 0; i < reps; i++){
+			auto start = std::chrono::steady_clock::now();
+			auto names = crona::NameAnalysis::build(ast);
+			TypeAnalysis * types = names == nullptr ? nullptr
+				: TypeAnalysis::build(names);
+			ms += bench::millisSince(start);
+			if (types == nullptr){
+				std::cerr << "program failed analysis\n";
+				return 1;
+			}
+			delete types;
+			delete names;
+		}
+		std::cout << fns << " functions: " << ms / perRep
+			<< " ms/analysis\n";
+	}
+	return 0;
+}
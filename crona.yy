@@ -13,7 +13,7 @@
 	#include "tokens.hpp"
 	#include "ast.hpp"
 	namespace crona {
-		class Scanner;
+		class TokenStream;
 	}
 
 //The following definition is required when 
@@ -29,7 +29,7 @@
 //End "requires" code
 }
 
-%parse-param { crona::Scanner &scanner }
+%parse-param { crona::TokenStream &scanner }
 %parse-param { crona::ProgramNode** root }
 %code{
    // C std code for utility functions
@@ -55,22 +55,22 @@
    crona::IntLitToken*                   transIntToken;
    crona::StrToken*                      transStrToken;
    crona::ProgramNode*                   transProgram;
-   std::list<crona::DeclNode *> *        transDeclList;
+   crona::SpanBuilder<crona::DeclNode *> * transDeclList;
    crona::DeclNode *                     transDecl;
    crona::VarDeclNode *                  transVarDecl;
-   std::list<crona::FormalDeclNode *> *  transFormals;
+   crona::SpanBuilder<crona::FormalDeclNode *> * transFormals;
    crona::FormalDeclNode *               transFormal;
    crona::TypeNode *                     transType;
    crona::LValNode *                     transLVal;
    crona::IDNode *                       transID;
    crona::FnDeclNode *                   transFn;
-   std::list<crona::VarDeclNode *> *     transVarDecls;
-   std::list<crona::StmtNode *> *        transStmts;
+   crona::SpanBuilder<crona::VarDeclNode *> * transVarDecls;
+   crona::SpanBuilder<crona::StmtNode *> * transStmts;
    crona::StmtNode *                     transStmt;
    crona::ExpNode *                      transExp;
    crona::AssignExpNode *                transAssignExp;
    crona::CallExpNode *                  transCallExp;
-   std::list<crona::ExpNode *> *         transActuals;
+   crona::SpanBuilder<crona::ExpNode *> * transActuals;
 }
 
 %define parse.assert
@@ -155,7 +155,7 @@
 
 program 	: globals
 		  {
-		  $$ = new ProgramNode($1);
+		  $$ = new ProgramNode($1->finish());
 		  *root = $$;
 		  }
 
@@ -167,7 +167,7 @@ globals 	: globals decl
 	  	  }
 		| /* epsilon */
 		  {
-		  $$ = new std::list<DeclNode * >();
+		  $$ = Arena::makeCurrent<SpanBuilder<DeclNode *>>();
 		  }
 
 decl 		: varDecl SEMICOLON
@@ -177,57 +177,55 @@ decl 		: varDecl SEMICOLON
 
 varDecl 	: id COLON type
 		  {
-		  size_t line = $1->line();
-		  size_t col = $1->col();
-		  $$ = new VarDeclNode(line, col, $3, $1);
+		  $$ = new VarDeclNode($1->offset(), $3, $1);
 		  }
 
 type 		: INT
 	  	  { 
-		  $$ = new IntTypeNode($1->line(), $1->col());
+		  $$ = new IntTypeNode($1->offset());
 		  }
 		| INT ARRAY LBRACE INTLITERAL RBRACE
 	  	  { 
-		  auto prim = new IntTypeNode($1->line(), $1->col());
-		  $$ = new ArrayTypeNode($1->line(), $1->col(), prim, $4->num());
+		  auto prim = new IntTypeNode($1->offset());
+		  $$ = new ArrayTypeNode($1->offset(), prim, $4->num());
 		  }
 		| BOOL
 		  {
-		  $$ = new BoolTypeNode($1->line(), $1->col());
+		  $$ = new BoolTypeNode($1->offset());
 		  }
 		| BOOL ARRAY LBRACE INTLITERAL RBRACE
 		  {
-		  auto prim = new BoolTypeNode($1->line(), $1->col());
-		  $$ = new ArrayTypeNode($1->line(), $1->col(), prim, $4->num());
+		  auto prim = new BoolTypeNode($1->offset());
+		  $$ = new ArrayTypeNode($1->offset(), prim, $4->num());
 		  }
 		| BYTE
 		  {
-		  $$ = new ByteTypeNode($1->line(), $1->col());
+		  $$ = new ByteTypeNode($1->offset());
 		  }
 		| BYTE ARRAY LBRACE INTLITERAL RBRACE
 		  {
-		  auto prim = new ByteTypeNode($1->line(), $1->col());
-		  $$ = new ArrayTypeNode($1->line(), $1->col(), prim, $4->num());
+		  auto prim = new ByteTypeNode($1->offset());
+		  $$ = new ArrayTypeNode($1->offset(), prim, $4->num());
 		  }
 		| STRING
 		  {
-		  auto prim = new ByteTypeNode($1->line(), $1->col());
-		  $$ = new ArrayTypeNode($1->line(), $1->col(), prim, 0);
+		  auto prim = new ByteTypeNode($1->offset());
+		  $$ = new ArrayTypeNode($1->offset(), prim, 0);
 		  }
 		| VOID
 		  {
-		  $$ = new VoidTypeNode($1->line(), $1->col());
+		  $$ = new VoidTypeNode($1->offset());
 		  }
 
 fnDecl 		: id COLON type formals fnBody
 		  {
-		  $$ = new FnDeclNode($1->line(), $1->col(), 
-		    $1, $3, $4, $5);
+		  $$ = new FnDeclNode($1->offset(), 
+		    $1, $3, $4->finish(), $5->finish());
 		  }
 
 formals 	: LPAREN RPAREN
 		  {
-		  $$ = new std::list<FormalDeclNode *>();
+		  $$ = Arena::makeCurrent<SpanBuilder<FormalDeclNode *>>();
 		  }
 		| LPAREN formalsList RPAREN
 		  {
@@ -237,18 +235,18 @@ formals 	: LPAREN RPAREN
 
 formalsList	: formalDecl
 		  {
-		  $$ = new std::list<FormalDeclNode *>();
+		  $$ = Arena::makeCurrent<SpanBuilder<FormalDeclNode *>>();
 		  $$->push_back($1);
 		  }
-		| formalDecl COMMA formalsList 
+		| formalsList COMMA formalDecl
 		  {
-		  $$ = $3;
-		  $$->push_front($1);
+		  $$ = $1;
+		  $$->push_back($3);
 		  }
 
 formalDecl 	: id COLON type
 		  {
-		  $$ = new FormalDeclNode($1->line(), $1->col(), 
+		  $$ = new FormalDeclNode($1->offset(), 
 		    $3, $1);
 		  }
 
@@ -259,7 +257,7 @@ fnBody		: LCURLY stmtList RCURLY
 
 stmtList 	: /* epsilon */
 	   	  {
-		  $$ = new std::list<StmtNode *>();
+		  $$ = Arena::makeCurrent<SpanBuilder<StmtNode *>>();
 		  //$$->push_back($1);
 	   	  }
 		| stmtList stmt
@@ -274,131 +272,131 @@ stmt		: varDecl SEMICOLON
 		  }
 		| assignExp SEMICOLON
 		  {
-		  $$ = new AssignStmtNode($1->line(), $1->col(), $1); 
+		  $$ = new AssignStmtNode($1->offset(), $1); 
 		  }
 		| lval DASHDASH SEMICOLON
 		  {
-		  $$ = new PostDecStmtNode($2->line(), $2->col(), $1);
+		  $$ = new PostDecStmtNode($2->offset(), $1);
 		  }
 		| lval CROSSCROSS SEMICOLON
 		  {
-		  $$ = new PostIncStmtNode($2->line(), $2->col(), $1);
+		  $$ = new PostIncStmtNode($2->offset(), $1);
 		  }
 		| READ lval SEMICOLON
 		  {
-		  $$ = new ReadStmtNode($1->line(), $1->col(), $2);
+		  $$ = new ReadStmtNode($1->offset(), $2);
 		  }
 		| WRITE exp SEMICOLON
 		  {
-		  $$ = new WriteStmtNode($1->line(), $1->col(), $2);
+		  $$ = new WriteStmtNode($1->offset(), $2);
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  $$ = new IfStmtNode($1->line(), $1->col(), $3, $6);
+		  $$ = new IfStmtNode($1->offset(), $3,
+		    $6->finish());
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY ELSE LCURLY stmtList RCURLY
 		  {
-		  $$ = new IfElseStmtNode($1->line(), $1->col(), $3, 
-		    $6, $10);
+		  $$ = new IfElseStmtNode($1->offset(), $3, 
+		    $6->finish(), $10->finish());
 		  }
 		| WHILE LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  $$ = new WhileStmtNode($1->line(), $1->col(), $3, $6);
+		  $$ = new WhileStmtNode($1->offset(), $3,
+		    $6->finish());
 		  }
 		| RETURN exp SEMICOLON
 		  {
-		  $$ = new ReturnStmtNode($1->line(), $1->col(), $2);
+		  $$ = new ReturnStmtNode($1->offset(), $2);
 		  }
 		| RETURN SEMICOLON
 		  {
-		  $$ = new ReturnStmtNode($1->line(), $1->col(), nullptr);
+		  $$ = new ReturnStmtNode($1->offset(), nullptr);
 		  }
 		| callExp SEMICOLON
-		  { $$ = new CallStmtNode($1->line(), $1->col(), $1); }
+		  { $$ = new CallStmtNode($1->offset(), $1); }
 
 exp		: assignExp 
 		  { $$ = $1; } 
 		| exp DASH exp
 	  	  {
-		  $$ = new MinusNode($2->line(), $2->col(), $1, $3);
+		  $$ = new MinusNode($2->offset(), $1, $3);
 		  }
 		| exp CROSS exp
 	  	  {
-		  $$ = new PlusNode($2->line(), $2->col(), $1, $3);
+		  $$ = new PlusNode($2->offset(), $1, $3);
 		  }
 		| exp STAR exp
 	  	  {
-		  $$ = new TimesNode($2->line(), $2->col(), $1, $3);
+		  $$ = new TimesNode($2->offset(), $1, $3);
 		  }
 		| exp SLASH exp
 	  	  {
-		  $$ = new DivideNode($2->line(), $2->col(), $1, $3);
+		  $$ = new DivideNode($2->offset(), $1, $3);
 		  }
 		| exp AND exp
 	  	  {
-		  $$ = new AndNode($2->line(), $2->col(), $1, $3);
+		  $$ = new AndNode($2->offset(), $1, $3);
 		  }
 		| exp OR exp
 	  	  {
-		  $$ = new OrNode($2->line(), $2->col(), $1, $3);
+		  $$ = new OrNode($2->offset(), $1, $3);
 		  }
 		| exp EQUALS exp
 	  	  {
-		  $$ = new EqualsNode($2->line(), $2->col(), $1, $3);
+		  $$ = new EqualsNode($2->offset(), $1, $3);
 		  }
 		| exp NOTEQUALS exp
 	  	  {
-		  $$ = new NotEqualsNode($2->line(), $2->col(), $1, $3);
+		  $$ = new NotEqualsNode($2->offset(), $1, $3);
 		  }
 		| exp GREATER exp
 	  	  {
-		  $$ = new GreaterNode($2->line(), $2->col(), $1, $3);
+		  $$ = new GreaterNode($2->offset(), $1, $3);
 		  }
 		| exp GREATEREQ exp
 	  	  {
-		  $$ = new GreaterEqNode($2->line(), $2->col(), $1, $3);
+		  $$ = new GreaterEqNode($2->offset(), $1, $3);
 		  }
 		| exp LESS exp
 	  	  {
-		  $$ = new LessNode($2->line(), $2->col(), $1, $3);
+		  $$ = new LessNode($2->offset(), $1, $3);
 		  }
 		| exp LESSEQ exp
 	  	  {
-		  $$ = new LessEqNode($2->line(), $2->col(), $1, $3);
+		  $$ = new LessEqNode($2->offset(), $1, $3);
 		  }
 		| NOT exp
 	  	  {
-		  $$ = new NotNode($1->line(), $1->col(), $2);
+		  $$ = new NotNode($1->offset(), $2);
 		  }
 		| DASH term
 	  	  {
-		  $$ = new NegNode($1->line(), $1->col(), $2);
+		  $$ = new NegNode($1->offset(), $2);
 		  }
 		| term 
 	  	  { $$ = $1; }
 
 assignExp	: lval ASSIGN exp
 		  {
-		  $$ = new AssignExpNode($2->line(), $2->col(), $1, $3);
+		  $$ = new AssignExpNode($2->offset(), $1, $3);
 		  }
 
 callExp		: id LPAREN RPAREN
 		  {
-		  std::list<ExpNode *> * noargs =
-		    new std::list<ExpNode *>();
-		  $$ = new CallExpNode($1->line(), $1->col(), $1, noargs);
+		  $$ = new CallExpNode($1->offset(), $1,
+		    Span<ExpNode *>());
 		  }
 		| id LPAREN actualsList RPAREN
 		  {
-		  $$ = new CallExpNode($1->line(), $1->col(), $1, $3);
+		  $$ = new CallExpNode($1->offset(), $1,
+		    $3->finish());
 		  }
 
 actualsList	: exp
 		  {
-		  std::list<ExpNode *> * list =
-		    new std::list<ExpNode *>();
-		  list->push_back($1);
-		  $$ = list;
+		  $$ = Arena::makeCurrent<SpanBuilder<ExpNode *>>();
+		  $$->push_back($1);
 		  }
 		| actualsList COMMA exp
 		  {
@@ -409,15 +407,15 @@ actualsList	: exp
 term 		: lval
 		  { $$ = $1; }
 		| INTLITERAL 
-		  { $$ = new IntLitNode($1->line(), $1->col(), $1->num()); }
+		  { $$ = new IntLitNode($1->offset(), $1->num()); }
 		| STRLITERAL 
-		  { $$ = new StrLitNode($1->line(), $1->col(), $1->str()); }
+		  { $$ = new StrLitNode($1->offset(), $1->str()); }
 		| TRUE
-		  { $$ = new TrueNode($1->line(), $1->col()); }
+		  { $$ = new TrueNode($1->offset()); }
 		| FALSE
-		  { $$ = new FalseNode($1->line(), $1->col()); }
+		  { $$ = new FalseNode($1->offset()); }
 		| HAVOC
-		  { $$ = new HavocNode($1->line(), $1->col()); }
+		  { $$ = new HavocNode($1->offset()); }
 		| LPAREN exp RPAREN
 		  { $$ = $2; }
 		| callExp
@@ -431,17 +429,18 @@ lval		: id
 		  }
 		| id LBRACE exp RBRACE
 		  {
-		  $$ = new IndexNode($1->line(), $1->col(), $1, $3);
+		  $$ = new IndexNode($1->offset(), $1, $3);
 		  }
 
 id		: ID
 		  {
-		  $$ = new IDNode($1->line(), $1->col(), $1->value()); 
+		  $$ = new IDNode($1->offset(), $1->value(), 
+		    $1->id()); 
 		  }
 	
 %%
 
 void crona::Parser::error(const std::string& msg){
-	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	Report::out() << msg << std::endl;
+	Report::emit("syntax error");
 }
@@ -0,0 +1,403 @@
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include "driver.hpp"
+#include "errors.hpp"
+#include "token_file.hpp"
+#include "time_report.hpp"
+
+namespace crona{
+
+DriverOptions::DriverOptions()
+: inFile(nullptr), tokensFile(nullptr), binaryTokens(false),
+  tokensFrom(nullptr), checkParse(false),
+  unparseFile(nullptr), namesFile(nullptr), checkTypes(false),
+  threeACFile(nullptr), cacheDir(nullptr), emitASTCache(false),
+  timeReport(false), timeReportJSON(nullptr), traceFile(nullptr),
+  flatAST(false), fastScanner(false), scanThreads(1), parseThreads(1),
+  lazyBodies(false), rdParser(false), analysisThreads(1){
+}
+
+bool DriverOptions::threadCount(const char * arg, size_t& count,
+	std::ostream& err
+){
+	char * end = nullptr;
+	long val = strtol(arg, &end, 10);
+	if (end == arg || *end != '\0' || val < 1){
+		err << "Bad thread count " << arg << std::endl;
+		return false;
+	}
+	count = static_cast<size_t>(val);
+	return true;
+}
+
+bool DriverOptions::parse(int argc, const char ** argv, std::ostream& err){
+	bool useful = false;
+	for (int i = 1 ; i < argc ; i++){
+		if (strcmp(argv[i], "--cache") == 0){
+			defaultCacheDir = ProcCache::defaultDir();
+			cacheDir = defaultCacheDir.c_str();
+		} else if (strcmp(argv[i], "--cache-dir") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			cacheDir = argv[i];
+		} else if (strcmp(argv[i], "--emit-ast-cache") == 0){
+			emitASTCache = true;
+			useful = true;
+		} else if (strcmp(argv[i], "--time-report") == 0){
+			timeReport = true;
+		} else if (strcmp(argv[i], "--time-report-json") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			timeReportJSON = argv[i];
+		} else if (strcmp(argv[i], "--trace-out") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			traceFile = argv[i];
+		} else if (strcmp(argv[i], "--ast=flat") == 0){
+			flatAST = true;
+		} else if (strcmp(argv[i], "--ast=tree") == 0){
+			flatAST = false;
+		} else if (strcmp(argv[i], "--format=bin") == 0){
+			binaryTokens = true;
+		} else if (strcmp(argv[i], "--format=text") == 0){
+			binaryTokens = false;
+		} else if (strcmp(argv[i], "--tokens-from") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			tokensFrom = argv[i];
+		} else if (strcmp(argv[i], "--scan-threads") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			if (!threadCount(argv[i], scanThreads, err)){ return false; }
+		} else if (strcmp(argv[i], "--parse-threads") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			if (!threadCount(argv[i], parseThreads, err)){ return false; }
+		} else if (strcmp(argv[i], "--analysis-threads") == 0){
+			i++;
+			if (i >= argc){ return false; }
+			if (!threadCount(argv[i], analysisThreads, err)){
+				return false;
+			}
+		} else if (strcmp(argv[i], "--lazy-bodies") == 0){
+			lazyBodies = true;
+		} else if (strcmp(argv[i], "--parser=rd") == 0){
+			rdParser = true;
+		} else if (strcmp(argv[i], "--parser=bison") == 0){
+			rdParser = false;
+		} else if (strcmp(argv[i], "--scanner=fast") == 0){
+			fastScanner = true;
+		} else if (strcmp(argv[i], "--scanner=flex") == 0){
+			fastScanner = false;
+		} else if (argv[i][0] == '-'){
+			if (argv[i][1] == 't'){
+				i++;
+				tokensFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'p'){
+				checkParse = true;
+				useful = true;
+			} else if (argv[i][1] == 'u'){
+				i++;
+				if (i >= argc){ return false; }
+				unparseFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'n'){
+				i++;
+				namesFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'c'){
+				checkTypes = true;
+				useful = true;
+			} else if (argv[i][1] == 'a'){
+				i++;
+				if (i >= argc){ return false; }
+				threeACFile = argv[i];
+				useful = true;
+			} else {
+				err << "Unrecognized argument: ";
+				err << argv[i] << std::endl;
+				return false;
+			}
+		} else {
+			if (inFile == nullptr){
+				inFile = argv[i];
+			} else {
+				err << "Only 1 input file allowed";
+				err << argv[i] << std::endl;
+				return false;
+			}
+		}
+	}
+	if (inFile == nullptr){
+		return false;
+	}
+	if (!useful){
+		err << "Hey, you didn't tell cronac to do anything!\n";
+		return false;
+	}
+	//Type analysis and lowering only work on the tree
+	if (flatAST && (checkTypes || threeACFile != nullptr)){
+		err << "--ast=flat cannot be used with -c or -a\n";
+		return false;
+	}
+	return true;
+}
+
+std::ostream * OutputFiles::open(const char * path){
+	if (strcmp(path, "--") == 0){
+		return &Report::out();
+	}
+	std::ofstream * outStream = new std::ofstream(path);
+	if (!outStream->good()){
+		delete outStream;
+		std::string msg = "Bad output file ";
+		msg += path;
+		throw new InternalError(msg.c_str());
+	}
+	return outStream;
+}
+
+void OutputFiles::close(const char * path, std::ostream * stream){
+	if (stream != &Report::out()){
+		delete stream;
+	}
+}
+
+std::ostream * CapturedOutputs::open(const char * path){
+	if (strcmp(path, "--") == 0){
+		return &Report::out();
+	}
+	return new std::ostringstream();
+}
+
+void CapturedOutputs::close(const char * path, std::ostream * stream){
+	if (stream == &Report::out()){ return; }
+	std::ostringstream * captureStream =
+		static_cast<std::ostringstream *>(stream);
+	captured.push_back(std::make_pair(std::string(path),
+		captureStream->str()));
+	delete captureStream;
+}
+
+static void writeTokenStream(CompilationSession& session,
+	const char * outPath, bool binary, OutputFiles& files
+){
+	if (outPath == nullptr){
+		std::string msg = "No tokens output file given";
+		throw new InternalError(msg.c_str());
+	}
+
+	TokenBuffer * tokens = session.tokens();
+	std::ostream * out = files.open(outPath);
+	if (binary){
+		TokenFile::write(tokens, session.sourceText()->size(), *out);
+	} else {
+		tokens->outputTokens(*out);
+	}
+	files.close(outPath, out);
+}
+
+static void outputAST(ASTNode * ast, const char * outPath,
+	OutputFiles& files
+){
+	std::ostream * out = files.open(outPath);
+	ast->unparse(*out, 0);
+	files.close(outPath, out);
+}
+
+static bool doUnparsing(CompilationSession& session, const char * outPath,
+	OutputFiles& files
+){
+	ProgramNode * ast = session.ast();
+	if (ast == nullptr){
+		Report::err() << "No AST built\n";
+		return false;
+	}
+
+	outputAST(ast, outPath, files);
+	return true;
+}
+
+static bool doFlatUnparsing(FlatAST * flat, const char * outPath,
+	OutputFiles& files
+){
+	if (flat == nullptr){
+		Report::err() << "No AST built\n";
+		return false;
+	}
+
+	std::ostream * out = files.open(outPath);
+	flat->unparse(*out);
+	files.close(outPath, out);
+	return true;
+}
+
+static void write3AC(IRProgram * prog, const char * outPath,
+	OutputFiles& files
+){
+	if (outPath == nullptr){
+		throw new InternalError("Null 3AC flat file given");
+	}
+	std::string flatProg;
+	{
+		PhaseTimer timer("3AC output");
+		flatProg = prog->toString();
+	}
+	std::ostream * out = files.open(outPath);
+	*out << flatProg << std::endl;
+	files.close(outPath, out);
+}
+
+int Driver::run(CompilationSession& session, const DriverOptions& opts,
+	OutputFiles& files
+){
+	ProcCache * cache = nullptr;
+	if (opts.cacheDir != nullptr){
+		cache = new ProcCache(opts.cacheDir);
+		session.setCache(cache);
+		session.setASTCacheDir(opts.cacheDir);
+	}
+	session.setFastScanner(opts.fastScanner);
+	session.setScanThreads(opts.scanThreads);
+	session.setParseThreads(opts.parseThreads);
+	session.setLazyBodies(opts.lazyBodies);
+	session.setRDParser(opts.rdParser);
+	session.setAnalysisThreads(opts.analysisThreads);
+	session.setTokenFile(opts.tokensFrom);
+	TimeReport * report = nullptr;
+	if (opts.timeReport || opts.timeReportJSON != nullptr){
+		report = new TimeReport();
+		TimeReport::activate(report);
+	}
+	Tracer * tracer = nullptr;
+	if (opts.traceFile != nullptr){
+		tracer = new Tracer();
+		Tracer::activate(tracer);
+	}
+
+	int res = runPhases(session, opts, files);
+
+	if (cache != nullptr){
+		//Only a run that produced 3AC has hits and misses
+		// worth reporting
+		if (cache->stored()){
+			Report::err() << "cache: " << cache->hits() << " hits, "
+				<< cache->misses() << " misses\n";
+		}
+		delete cache;
+	}
+	if (report != nullptr){
+		TimeReport::activate(nullptr);
+		if (opts.timeReport){
+			report->print(Report::err());
+		}
+		if (opts.timeReportJSON != nullptr){
+			try {
+				std::ostream * out = files.open(opts.timeReportJSON);
+				report->printJSON(*out);
+				files.close(opts.timeReportJSON, out);
+			} catch (InternalError * e){
+				Report::err() << "InternalError: " << e->msg() << "\n";
+				res = 1;
+			}
+		}
+		delete report;
+	}
+	if (tracer != nullptr){
+		Tracer::activate(nullptr);
+		try {
+			std::ostream * out = files.open(opts.traceFile);
+			tracer->write(*out);
+			files.close(opts.traceFile, out);
+		} catch (InternalError * e){
+			Report::err() << "InternalError: " << e->msg() << "\n";
+			res = 1;
+		}
+		delete tracer;
+	}
+	return res;
+}
+
+int Driver::runPhases(CompilationSession& session, const DriverOptions& opts,
+	OutputFiles& files
+){
+	try {
+		//Each phase runs at most once, no matter how many
+		// outputs are requested from it
+		if (opts.tokensFile != nullptr){
+			//Token positions are looked up in the source
+			SourceScope sourceScope(session.sourceText());
+			writeTokenStream(session, opts.tokensFile,
+				opts.binaryTokens, files);
+		}
+		if (opts.emitASTCache){
+			//Saved from the flat AST if that is what the
+			// other outputs use, to not parse twice
+			if (opts.flatAST){ session.flatAST(); }
+			std::string dir = opts.cacheDir != nullptr ? opts.cacheDir
+				: ProcCache::defaultDir();
+			session.saveASTCache(dir);
+		}
+		if (opts.flatAST){
+			if (opts.checkParse && !session.flatAST()){
+				Report::err() << "Parse failed" << std::endl;
+			}
+			if (opts.unparseFile != nullptr){
+				doFlatUnparsing(session.flatAST(), opts.unparseFile, files);
+			}
+			if (opts.namesFile){
+				FlatAST * named = session.namedFlatAST();
+				if (named == nullptr){
+					Report::err() << "Name Analysis Failed\n";
+					return 1;
+				}
+				doFlatUnparsing(named, opts.namesFile, files);
+			}
+		} else {
+			if (opts.checkParse){
+				if (!session.declarations()){
+					Report::err() << "Parse failed" << std::endl;
+				}
+			}
+			if (opts.unparseFile != nullptr){
+				doUnparsing(session, opts.unparseFile, files);
+			}
+			if (opts.namesFile){
+				NameAnalysis * na;
+				na = session.nameAnalysis();
+				if (na == nullptr){
+					Report::err() << "Name Analysis Failed\n";
+					return 1;
+				}
+				outputAST(na->ast, opts.namesFile, files);
+			}
+		}
+		if (opts.checkTypes){
+			TypeAnalysis * ta;
+			ta = session.typeAnalysis();
+			if (ta == nullptr){
+				Report::err() << "Type Analysis Failed\n";
+				return 1;
+			}
+		}
+		if (opts.threeACFile != nullptr){
+			auto prog = session.ir();
+			if (prog == nullptr){ return 1; }
+			write3AC(prog, opts.threeACFile, files);
+		}
+		session.reportHeld();
+	} catch (ToDoError * e){
+		Report::err() << "ToDoError: " << e->msg() << "\n";
+		return 1;
+	} catch (InternalError * e){
+		Report::err() << "InternalError: " << e->msg() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+}
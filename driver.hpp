@@ -0,0 +1,115 @@
+#ifndef CRONA_DRIVER_HPP
+#define CRONA_DRIVER_HPP
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "session.hpp"
+
+namespace crona{
+
+//The outputs requested on a cronac command line
+class DriverOptions{
+public:
+	DriverOptions();
+
+	//Fill in the options from a command line. argv[argc]
+	// must be a null pointer, as it is for main. If the
+	// command line is bad, a message is written to err
+	// and false is returned.
+	bool parse(int argc, const char ** argv, std::ostream& err);
+
+	//Read a thread count of at least 1 from arg into count.
+	// If arg is not one, a message is written to err and
+	// false is returned.
+	static bool threadCount(const char * arg, size_t& count,
+		std::ostream& err);
+
+	const char * inFile;
+	const char * tokensFile;
+	//Write the tokens in TokenFile's binary form
+	// (--format=bin) rather than as text
+	bool binaryTokens;
+	//Read the tokens from a TokenFile instead of scanning
+	const char * tokensFrom;
+	bool checkParse;
+	const char * unparseFile;
+	const char * namesFile;
+	bool checkTypes;
+	const char * threeACFile;
+	//Directory of the per-function 3AC cache, or nullptr
+	// if caching is off
+	const char * cacheDir;
+	std::string defaultCacheDir;
+	//Save the parsed AST in the cache directory (the default
+	// one without --cache-dir) for later runs with a cache to
+	// load instead of scanning and parsing (--emit-ast-cache)
+	bool emitASTCache;
+	//Print a TimeReport to stderr and/or write it as JSON
+	bool timeReport;
+	const char * timeReportJSON;
+	//Write a Chrome trace of the compilation
+	const char * traceFile;
+	//Parse, unparse and name-analyze over a FlatAST
+	// (--ast=flat) instead of the ASTNode tree. Not allowed
+	// with -c or -a, which need the tree.
+	bool flatAST;
+	//Scan with the hand-written FastScanner
+	// (--scanner=fast) instead of the flex Scanner
+	bool fastScanner;
+	//Scan large inputs in pieces on this many threads
+	// (--scan-threads <n>)
+	size_t scanThreads;
+	//Parse large inputs in pieces on this many threads
+	// (--parse-threads <n>)
+	size_t parseThreads;
+	//Parse function bodies only when they are needed
+	// (--lazy-bodies), so that -p alone only checks the
+	// declarations and signatures
+	bool lazyBodies;
+	//Parse with the hand-written RDParser (--parser=rd)
+	// instead of the bison Parser
+	bool rdParser;
+	//Analyze function bodies on this many threads
+	// (--analysis-threads <n>)
+	size_t analysisThreads;
+};
+
+//Where the driver's outputs go. An output path of "--"
+// means standard output (i.e. Report::out()); any other
+// path is written as a file.
+class OutputFiles{
+public:
+	virtual ~OutputFiles(){ }
+	virtual std::ostream * open(const char * path);
+	virtual void close(const char * path, std::ostream * stream);
+};
+
+//Outputs that are held in memory rather than written to
+// disk, so they can be shipped elsewhere (see server.cpp)
+class CapturedOutputs : public OutputFiles{
+public:
+	virtual std::ostream * open(const char * path) override;
+	virtual void close(const char * path, std::ostream * stream) override;
+	const std::vector<std::pair<std::string, std::string>>& files(){
+		return captured;
+	}
+private:
+	std::vector<std::pair<std::string, std::string>> captured;
+};
+
+//Produce every output asked for by opts from a single
+// compilation session. Returns the cronac exit code.
+class Driver{
+public:
+	static int run(CompilationSession& session,
+		const DriverOptions& opts, OutputFiles& files);
+private:
+	static int runPhases(CompilationSession& session,
+		const DriverOptions& opts, OutputFiles& files);
+};
+
+}
+
+#endif
@@ -7,6 +7,9 @@
 #define TODO(x) throw new ToDoError(CODELOC #x);
 
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
 
 namespace crona{
 
@@ -26,15 +29,49 @@ private:
 	const char * myMsg;
 };
 
+//All diagnostics go through Report. By default they are
+// written to std::cerr (and parser messages to std::cout),
+// but each thread can redirect its own diagnostics with 
+// redirect(), so that several compilations running at 
+// once (see batch.cpp) don't interleave their output.
 class Report{
 public:
+	static std::ostream& err(){ return *errSink(); }
+	static std::ostream& out(){ return *outSink(); }
+
+	static void redirect(std::ostream * errIn, std::ostream * outIn){
+		errSink() = errIn;
+		outSink() = outIn;
+	}
+
+	static void restore(){
+		redirect(&std::cerr, &std::cout);
+	}
+
+	//Write a complete message in one piece, so that
+	// threads sharing std::cerr can't split a line
+	static void emit(const std::string& msg){
+		std::lock_guard<std::mutex> guard(sinkLock());
+		err() << msg << std::endl;
+	}
+
+	//emit() each line of text, e.g. messages that were held
+	// back while another stream was redirected in
+	static void emitLines(const std::string& text){
+		std::istringstream lines(text);
+		std::string line;
+		while (std::getline(lines, line)){
+			emit(line);
+		}
+	}
+
 	static void fatal(
 		size_t l, 
 		size_t c, 
 		const char * msg
 	){
-		std::cerr << "FATAL [" << l << "," << c << "]: " 
-		<< msg  << std::endl;
+		emit("FATAL [" + std::to_string(l) + "," 
+			+ std::to_string(c) + "]: " + msg);
 	}
 
 	static void fatal(
@@ -50,8 +87,8 @@ public:
 		size_t c,
 		const char * msg
 	){
-		std::cerr << "*WARNING* [" << l << "," << c << "]: " 
-		<< msg  << std::endl;
+		emit("*WARNING* [" + std::to_string(l) + "," 
+			+ std::to_string(c) + "]: " + msg);
 	}
 
 	static void warn(
@@ -61,6 +98,19 @@ public:
 	){
 		warn(l,c,msg.c_str());
 	}
+private:
+	static std::ostream *& errSink(){
+		thread_local std::ostream * sink = &std::cerr;
+		return sink;
+	}
+	static std::ostream *& outSink(){
+		thread_local std::ostream * sink = &std::cout;
+		return sink;
+	}
+	static std::mutex& sinkLock(){
+		static std::mutex lock;
+		return lock;
+	}
 };
 
 }
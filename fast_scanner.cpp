@@ -0,0 +1,415 @@
+#include <climits>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "fast_scanner.hpp"
+#include "errors.hpp"
+#include "interner.hpp"
+
+namespace crona{
+
+using TokenKind = crona::Parser::token;
+using Lexeme = crona::Parser::semantic_type;
+
+static bool isDigit(char c){
+	return c >= '0' && c <= '9';
+}
+
+static bool isWordStart(char c){
+	char lower = static_cast<char>(c | 0x20);
+	return (lower >= 'a' && lower <= 'z') || c == '_';
+}
+
+static bool isWordChar(char c){
+	return isWordStart(c) || isDigit(c);
+}
+
+static bool isBlank(char c){
+	return c == ' ' || c == '\t' || c == '\n';
+}
+
+#if defined(__SSE2__)
+//The index of the first byte marked in a movemask
+static unsigned firstSet(int mask){
+	return static_cast<unsigned>(__builtin_ctz(static_cast<unsigned>(mask)));
+}
+
+static __m128i load16(const char * p){
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+static __m128i inRange(__m128i chunk, char lo, char hi){
+	//Bytes of 0x80 and up compare as negative, so are
+	// never in range
+	return _mm_and_si128(
+		_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(lo - 1))),
+		_mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+#endif
+
+//The first byte from p on that is not a space, tab or
+// newline (or end)
+static const char * skipBlanks(const char * p, const char * end){
+	//Usually there is no more than a space to skip
+	if (p == end || !isBlank(*p)){ return p; }
+#if defined(__SSE2__)
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (end - p >= 16){
+		__m128i chunk = load16(p);
+		__m128i blank = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+				_mm_cmpeq_epi8(chunk, tab)),
+			_mm_cmpeq_epi8(chunk, newline));
+		int notBlank = ~_mm_movemask_epi8(blank) & 0xFFFF;
+		if (notBlank != 0){ return p + firstSet(notBlank); }
+		p += 16;
+	}
+#endif
+	while (p < end && isBlank(*p)){ p++; }
+	return p;
+}
+
+//The first byte from p on that can't be part of an
+// identifier
+static const char * skipWordChars(const char * p, const char * end){
+#if defined(__SSE2__)
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i underscore = _mm_set1_epi8('_');
+	while (end - p >= 16){
+		__m128i chunk = load16(p);
+		__m128i word = _mm_or_si128(
+			_mm_or_si128(
+				inRange(_mm_or_si128(chunk, caseBit), 'a', 'z'),
+				inRange(chunk, '0', '9')),
+			_mm_cmpeq_epi8(chunk, underscore));
+		int notWord = ~_mm_movemask_epi8(word) & 0xFFFF;
+		if (notWord != 0){ return p + firstSet(notWord); }
+		p += 16;
+	}
+#endif
+	while (p < end && isWordChar(*p)){ p++; }
+	return p;
+}
+
+//The first quote, backslash or newline from p on (or end):
+// the only bytes that end a run of string literal text
+static const char * findStringStop(const char * p, const char * end){
+#if defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (end - p >= 16){
+		__m128i chunk = load16(p);
+		__m128i stop = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+				_mm_cmpeq_epi8(chunk, backslash)),
+			_mm_cmpeq_epi8(chunk, newline));
+		int stops = _mm_movemask_epi8(stop);
+		if (stops != 0){ return p + firstSet(stops); }
+		p += 16;
+	}
+#endif
+	while (p < end && *p != '"' && *p != '\\' && *p != '\n'){ p++; }
+	return p;
+}
+
+//Every keyword is 2 to 6 letters long and lands in a
+// different one of 32 slots when hashed on its first two
+// letters and its length, so a word is a keyword exactly
+// when it matches the keyword in its slot
+class KeywordTable{
+public:
+	KeywordTable() : slots(){
+		add("int", TokenKind::INT);
+		add("bool", TokenKind::BOOL);
+		add("byte", TokenKind::BYTE);
+		add("array", TokenKind::ARRAY);
+		add("string", TokenKind::STRING);
+		add("void", TokenKind::VOID);
+		add("if", TokenKind::IF);
+		add("else", TokenKind::ELSE);
+		add("while", TokenKind::WHILE);
+		add("return", TokenKind::RETURN);
+		add("false", TokenKind::FALSE);
+		add("true", TokenKind::TRUE);
+		add("read", TokenKind::READ);
+		add("write", TokenKind::WRITE);
+		add("havoc", TokenKind::HAVOC);
+	}
+
+	static const KeywordTable& get(){
+		static const KeywordTable table;
+		return table;
+	}
+
+	//The keyword's token kind, or ID if word isn't one
+	int find(const char * word, size_t len) const {
+		if (len < 2 || len > 6){ return TokenKind::ID; }
+		const Slot& slot = slots[hash(word, len)];
+		if (slot.len == len && memcmp(slot.text, word, len) == 0){
+			return slot.kind;
+		}
+		return TokenKind::ID;
+	}
+private:
+	class Slot{
+	public:
+		const char * text;
+		size_t len;
+		int kind;
+	};
+
+	static size_t hash(const char * word, size_t len){
+		size_t first = static_cast<unsigned char>(word[0]);
+		size_t second = static_cast<unsigned char>(word[1]);
+		return (first + 9 * second + 3 * len) % 32;
+	}
+
+	void add(const char * text, int kind){
+		size_t len = strlen(text);
+		Slot& slot = slots[hash(text, len)];
+		if (slot.text != nullptr){
+			throw new InternalError("Keyword hash collision");
+		}
+		slot.text = text;
+		slot.len = len;
+		slot.kind = kind;
+	}
+
+	Slot slots[32];
+};
+
+FastScanner::FastScanner(const SourceBuffer * sourceIn)
+: FastScanner(sourceIn, 0, sourceIn->size()){
+}
+
+FastScanner::FastScanner(const SourceBuffer * sourceIn, size_t from,
+	size_t to
+)
+: source(sourceIn), pos(sourceIn->data() + from),
+  end(sourceIn->data() + to){
+}
+
+int FastScanner::yylex(Lexeme * const lval){
+	while (true){
+		pos = skipBlanks(pos, end);
+		if (pos == end){ return TokenKind::END; }
+		const char * start = pos;
+		char c = *pos;
+		if (isWordStart(c)){ return scanWord(lval, start); }
+		if (isDigit(c)){ return scanNumber(lval, start); }
+		pos++;
+		switch (c){
+		case '"': {
+			int kind = scanString(lval, start);
+			if (kind != 0){ return kind; }
+			continue;
+		}
+		case '[': return makeBareToken(lval, start, TokenKind::LBRACE);
+		case ']': return makeBareToken(lval, start, TokenKind::RBRACE);
+		case '{': return makeBareToken(lval, start, TokenKind::LCURLY);
+		case '}': return makeBareToken(lval, start, TokenKind::RCURLY);
+		case '(': return makeBareToken(lval, start, TokenKind::LPAREN);
+		case ')': return makeBareToken(lval, start, TokenKind::RPAREN);
+		case ';': return makeBareToken(lval, start, TokenKind::SEMICOLON);
+		case ':': return makeBareToken(lval, start, TokenKind::COLON);
+		case ',': return makeBareToken(lval, start, TokenKind::COMMA);
+		case '*': return makeBareToken(lval, start, TokenKind::STAR);
+		case '+':
+			return makeBareToken(lval, start, accept('+') ?
+				TokenKind::CROSSCROSS : TokenKind::CROSS);
+		case '-':
+			return makeBareToken(lval, start, accept('-') ?
+				TokenKind::DASHDASH : TokenKind::DASH);
+		case '!':
+			return makeBareToken(lval, start, accept('=') ?
+				TokenKind::NOTEQUALS : TokenKind::NOT);
+		case '=':
+			return makeBareToken(lval, start, accept('=') ?
+				TokenKind::EQUALS : TokenKind::ASSIGN);
+		case '<':
+			return makeBareToken(lval, start, accept('=') ?
+				TokenKind::LESSEQ : TokenKind::LESS);
+		case '>':
+			return makeBareToken(lval, start, accept('=') ?
+				TokenKind::GREATEREQ : TokenKind::GREATER);
+		case '&':
+			if (accept('&')){
+				return makeBareToken(lval, start, TokenKind::AND);
+			}
+			break;
+		case '|':
+			if (accept('|')){
+				return makeBareToken(lval, start, TokenKind::OR);
+			}
+			break;
+		case '/':
+			if (accept('/')){
+				//Comment. No token
+				const void * newline = memchr(pos, '\n',
+					static_cast<size_t>(end - pos));
+				pos = newline == nullptr ? end
+					: static_cast<const char *>(newline);
+				continue;
+			}
+			return makeBareToken(lval, start, TokenKind::SLASH);
+		case '\r':
+			if (accept('\n')){ continue; }
+			break;
+		}
+		//flex's yytext stops at a NUL, so it shows as nothing
+		std::string match = c == '\0' ? "" : std::string(1, c);
+		errAt(start, "Illegal character " + match);
+	}
+}
+
+int FastScanner::makeBareToken(Lexeme * lval, const char * start,
+	int kind
+){
+	lval->transToken = new Token(offsetOf(start), kind);
+	return kind;
+}
+
+int FastScanner::scanWord(Lexeme * lval, const char * start){
+	pos = skipWordChars(start + 1, end);
+	size_t len = static_cast<size_t>(pos - start);
+	int kind = KeywordTable::get().find(start, len);
+	if (kind != TokenKind::ID){
+		return makeBareToken(lval, start, kind);
+	}
+	StrRef name(start, len);
+	lval->transToken = new IDToken(offsetOf(start), name,
+		Interner::global().intern(name));
+	return TokenKind::ID;
+}
+
+int FastScanner::scanNumber(Lexeme * lval, const char * start){
+	long long value = 0;
+	bool overflow = false;
+	while (pos < end && isDigit(*pos)){
+		if (!overflow){
+			value = value * 10 + (*pos - '0');
+			overflow = value > INT_MAX;
+		}
+		pos++;
+	}
+	if (overflow){
+		errAt(start, "Integer literal too large; using max value");
+		value = INT_MAX;
+	}
+	lval->transToken = new IntLitToken(offsetOf(start),
+		static_cast<int>(value));
+	return TokenKind::INTLITERAL;
+}
+
+int FastScanner::scanString(Lexeme * lval, const char * start){
+	//crona.l has four rules for text starting with a quote,
+	// and flex takes the one with the longest match (the
+	// first of them, on a tie). This works out how far each
+	// would reach.
+
+	//A well-formed literal, either closed by a quote or
+	// (unterminated) cut off by a newline, the end of the
+	// input or a bad escape
+	const char * p = start + 1;
+	bool closed = false;
+	while (true){
+		p = findStringStop(p, end);
+		if (p == end || *p == '\n'){ break; }
+		if (*p == '"'){
+			closed = true;
+			p++;
+			break;
+		}
+		if (end - p < 2){ break; }
+		char escaped = p[1];
+		if (escaped != 'n' && escaped != 't' && escaped != '"'
+		  && escaped != '\\'){
+			break;
+		}
+		p += 2;
+	}
+	size_t goodLen = static_cast<size_t>(p - start);
+
+	//The bad-escape rules match the whole run up to the
+	// next quote or newline, so long as it has a backslash
+	// in it: with the closing quote, or (unterminated) with
+	// or without a final escaped quote
+	const char * runEnd = start + 1;
+	const char * firstBackslash = nullptr;
+	while (true){
+		runEnd = findStringStop(runEnd, end);
+		if (runEnd == end || *runEnd != '\\'){ break; }
+		if (firstBackslash == nullptr){ firstBackslash = runEnd; }
+		runEnd++;
+	}
+	size_t badUntermLen = 0;
+	size_t badLen = 0;
+	if (firstBackslash != nullptr){
+		badUntermLen = static_cast<size_t>(runEnd - start);
+		if (runEnd < end && *runEnd == '"'){
+			badLen = badUntermLen + 1;
+			if (runEnd[-1] == '\\' && firstBackslash < runEnd - 1){
+				badUntermLen = badLen;
+			}
+		}
+	}
+
+	if (badLen > goodLen && badLen > badUntermLen){
+		pos = start + badLen;
+		errAt(start, "String literal with bad escape sequence ignored");
+		return 0;
+	}
+	if (badUntermLen > goodLen){
+		pos = start + badUntermLen;
+		errAt(start, "Unterminated string literal"
+			" with bad escape sequence ignored");
+		return 0;
+	}
+	pos = start + goodLen;
+	if (!closed){
+		errAt(start, "Unterminated string literal ignored");
+		return 0;
+	}
+	lval->transToken = new StrToken(offsetOf(start),
+		StrRef(start, goodLen));
+	return TokenKind::STRLITERAL;
+}
+
+void FastScanner::errAt(const char * start, const std::string& msg){
+	LineCol where = source->position(offsetOf(start));
+	Report::fatal(where.line, where.col, msg);
+}
+
+void FastScanner::outputTokens(std::ostream& outstream){
+	Lexeme lexeme;
+	while (true){
+		int tokenKind = yylex(&lexeme);
+		if (tokenKind == TokenKind::END){
+			LineCol where = source->position(offsetOf(end));
+			outstream << "EOF"
+			  << " [" << where.line
+			  << "," << where.col << "]"
+			  << std::endl;
+			return;
+		}
+		outstream << lexeme.transToken->toString() << std::endl;
+	}
+}
+
+void FastScanner::fill(TokenBuffer * buffer){
+	Lexeme lexeme;
+	while (true){
+		int tokenKind = yylex(&lexeme);
+		if (tokenKind == TokenKind::END){
+			buffer->setEnd(offsetOf(end));
+			return;
+		}
+		buffer->push(lexeme.transToken);
+	}
+}
+
+}
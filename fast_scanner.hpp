@@ -0,0 +1,59 @@
+#ifndef CRONA_FAST_SCANNER_HPP
+#define CRONA_FAST_SCANNER_HPP
+
+#include <ostream>
+#include <string>
+#include "grammar.hh"
+#include "token_stream.hpp"
+#include "source_buffer.hpp"
+
+namespace crona{
+
+//A hand-written scanner for the same language as the flex
+// Scanner (crona.l), for --scanner=fast. It reads the
+// SourceBuffer directly rather than through an istream,
+// skips blanks and comments and scans identifiers and
+// string literals 16 bytes at a time with SSE2 (where it is
+// available), and recognizes keywords with a perfect hash.
+// It produces exactly the tokens and errors that Scanner
+// does, including for the oddities of crona.l's string
+// rules.
+class FastScanner : public TokenStream{
+public:
+	FastScanner(const SourceBuffer * sourceIn);
+	//Scan only the bytes of source from offset from up to
+	// to, which must start and end between tokens
+	FastScanner(const SourceBuffer * sourceIn, size_t from, size_t to);
+
+	virtual int yylex(crona::Parser::semantic_type * const lval) override;
+
+	void outputTokens(std::ostream& outstream);
+
+	//Scan the whole input into buffer, recording the
+	// position of the EOF token
+	void fill(TokenBuffer * buffer);
+private:
+	int makeBareToken(crona::Parser::semantic_type * lval,
+		const char * start, int kind);
+	int scanWord(crona::Parser::semantic_type * lval, const char * start);
+	int scanNumber(crona::Parser::semantic_type * lval, const char * start);
+	//Returns 0 if the literal was bad, and so made no token
+	int scanString(crona::Parser::semantic_type * lval, const char * start);
+	void errAt(const char * start, const std::string& msg);
+	//Consume c if it is next
+	bool accept(char c){
+		if (pos < end && *pos == c){ pos++; return true; }
+		return false;
+	}
+	uint32_t offsetOf(const char * pos) const {
+		return static_cast<uint32_t>(pos - source->data());
+	}
+
+	const SourceBuffer * source;
+	const char * pos;
+	const char * end;
+};
+
+}
+
+#endif
@@ -0,0 +1,709 @@
+#include "flat_ast.hpp"
+#include "ast.hpp"
+#include "errName.hpp"
+#include "errors.hpp"
+#include "symbol_table.hpp"
+#include "time_report.hpp"
+#include "types.hpp"
+
+namespace crona{
+
+FlatAST * FlatAST::build(ProgramNode * root){
+	FlatAST * flat = new FlatAST();
+	root->toFlat(flat);
+	flat->kinds.shrink_to_fit();
+	flat->offsets.shrink_to_fit();
+	flat->ends.shrink_to_fit();
+	flat->payloads.shrink_to_fit();
+	flat->strs.shrink_to_fit();
+	flat->names.shrink_to_fit();
+	return flat;
+}
+
+uint32_t FlatAST::open(Kind kind, uint32_t offset, uint32_t payload){
+	if (kinds.size() >= UINT32_MAX){
+		throw new InternalError("AST too large to flatten");
+	}
+	uint32_t node = static_cast<uint32_t>(kinds.size());
+	kinds.push_back(kind);
+	offsets.push_back(offset);
+	ends.push_back(node + 1);
+	payloads.push_back(payload);
+	return node;
+}
+
+void FlatAST::close(uint32_t node){
+	ends[node] = static_cast<uint32_t>(kinds.size());
+}
+
+uint32_t FlatAST::addString(StrRef text){
+	strs.push_back(text);
+	return static_cast<uint32_t>(strs.size() - 1);
+}
+
+void FlatAST::addName(uint32_t nameID, StrRef text){
+	if (nameID >= names.size()){ names.resize(nameID + 1); }
+	names[nameID] = text;
+}
+
+SemSymbol * FlatAST::symbol(uint32_t node) const {
+	if (symbols.empty()){ return nullptr; }
+	return symbols[node];
+}
+
+size_t FlatAST::bytes() const {
+	return kinds.capacity() * sizeof(uint8_t)
+		+ (offsets.capacity() + ends.capacity()
+		  + payloads.capacity()) * sizeof(uint32_t)
+		+ (strs.capacity() + names.capacity()) * sizeof(StrRef)
+		+ symbols.capacity() * sizeof(SemSymbol *);
+}
+
+//Building, from the ASTNode tree
+
+void ProgramNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::PROGRAM, offset());
+	for (auto decl : myGlobals){
+		decl->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void VarDeclNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::VAR_DECL, offset());
+	myType->toFlat(flat);
+	myID->toFlat(flat);
+	flat->close(node);
+}
+
+void FormalDeclNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::FORMAL_DECL, offset());
+	getTypeNode()->toFlat(flat);
+	ID()->toFlat(flat);
+	flat->close(node);
+}
+
+void FnDeclNode::toFlat(FlatAST * flat){
+	uint32_t formalCount = static_cast<uint32_t>(myFormals.size());
+	uint32_t node = flat->open(FlatAST::FN_DECL, offset(),
+		formalCount);
+	myID->toFlat(flat);
+	myRetType->toFlat(flat);
+	for (auto formal : myFormals){
+		formal->toFlat(flat);
+	}
+	for (auto stmt : body()){
+		stmt->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void AssignStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::ASSIGN_STMT, offset());
+	myExp->toFlat(flat);
+	flat->close(node);
+}
+
+void ReadStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::READ_STMT, offset());
+	myDst->toFlat(flat);
+	flat->close(node);
+}
+
+void WriteStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::WRITE_STMT, offset());
+	mySrc->toFlat(flat);
+	flat->close(node);
+}
+
+void PostDecStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::POST_DEC_STMT, offset());
+	myLVal->toFlat(flat);
+	flat->close(node);
+}
+
+void PostIncStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::POST_INC_STMT, offset());
+	myLVal->toFlat(flat);
+	flat->close(node);
+}
+
+void IfStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::IF_STMT, offset());
+	myCond->toFlat(flat);
+	for (auto stmt : myBody){
+		stmt->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void IfElseStmtNode::toFlat(FlatAST * flat){
+	uint32_t trueCount = static_cast<uint32_t>(myBodyTrue.size());
+	uint32_t node = flat->open(FlatAST::IF_ELSE_STMT, offset(),
+		trueCount);
+	myCond->toFlat(flat);
+	for (auto stmt : myBodyTrue){
+		stmt->toFlat(flat);
+	}
+	for (auto stmt : myBodyFalse){
+		stmt->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void WhileStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::WHILE_STMT, offset());
+	myCond->toFlat(flat);
+	for (auto stmt : myBody){
+		stmt->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void ReturnStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::RETURN_STMT, offset());
+	if (myExp != nullptr){
+		myExp->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void CallStmtNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::CALL_STMT, offset());
+	myCallExp->toFlat(flat);
+	flat->close(node);
+}
+
+void IDNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::ID, offset(), nameID);
+	flat->addName(nameID, name);
+}
+
+void IndexNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::INDEX, offset());
+	myBase->toFlat(flat);
+	myOffset->toFlat(flat);
+	flat->close(node);
+}
+
+void CallExpNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::CALL, offset());
+	myID->toFlat(flat);
+	for (auto arg : myArgs){
+		arg->toFlat(flat);
+	}
+	flat->close(node);
+}
+
+void AssignExpNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::ASSIGN, offset());
+	myDst->toFlat(flat);
+	mySrc->toFlat(flat);
+	flat->close(node);
+}
+
+void BinaryExpNode::binaryToFlat(FlatAST * flat, FlatAST::Kind kind){
+	uint32_t node = flat->open(kind, offset());
+	myExp1->toFlat(flat);
+	myExp2->toFlat(flat);
+	flat->close(node);
+}
+
+void PlusNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::PLUS);
+}
+
+void MinusNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::MINUS);
+}
+
+void TimesNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::TIMES);
+}
+
+void DivideNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::DIVIDE);
+}
+
+void AndNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::AND);
+}
+
+void OrNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::OR);
+}
+
+void EqualsNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::EQUALS);
+}
+
+void NotEqualsNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::NOT_EQUALS);
+}
+
+void LessNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::LESS);
+}
+
+void LessEqNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::LESS_EQ);
+}
+
+void GreaterNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::GREATER);
+}
+
+void GreaterEqNode::toFlat(FlatAST * flat){
+	binaryToFlat(flat, FlatAST::GREATER_EQ);
+}
+
+void NegNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::NEG, offset());
+	myExp->toFlat(flat);
+	flat->close(node);
+}
+
+void NotNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::NOT, offset());
+	myExp->toFlat(flat);
+	flat->close(node);
+}
+
+void IntLitNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::INT_LIT, offset(),
+		static_cast<uint32_t>(myNum));
+}
+
+void StrLitNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::STR_LIT, offset(), flat->addString(myStr));
+}
+
+//A promotion has no source form of its own
+void ByteToIntNode::toFlat(FlatAST * flat){
+	myChild->toFlat(flat);
+}
+
+void TrueNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::TRUE, offset());
+}
+
+void FalseNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::FALSE, offset());
+}
+
+void HavocNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::HAVOC, offset());
+}
+
+void VoidTypeNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::VOID_TYPE, offset());
+}
+
+void IntTypeNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::INT_TYPE, offset());
+}
+
+void BoolTypeNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::BOOL_TYPE, offset());
+}
+
+void ByteTypeNode::toFlat(FlatAST * flat){
+	flat->open(FlatAST::BYTE_TYPE, offset());
+}
+
+void ArrayTypeNode::toFlat(FlatAST * flat){
+	uint32_t node = flat->open(FlatAST::ARRAY_TYPE, offset(),
+		static_cast<uint32_t>(myLen));
+	myBase->toFlat(flat);
+	flat->close(node);
+}
+
+//Unparsing
+
+static void doIndent(std::ostream& out, int indent){
+	for (int k = 0 ; k < indent; k++){ out << "\t"; }
+}
+
+static const char * binaryOp(FlatAST::Kind kind){
+	switch (kind){
+	case FlatAST::PLUS: return " + ";
+	case FlatAST::MINUS: return " - ";
+	case FlatAST::TIMES: return " * ";
+	case FlatAST::DIVIDE: return " / ";
+	case FlatAST::AND: return " && ";
+	case FlatAST::OR: return " || ";
+	case FlatAST::EQUALS: return " == ";
+	case FlatAST::NOT_EQUALS: return " != ";
+	case FlatAST::LESS: return " < ";
+	case FlatAST::LESS_EQ: return " <= ";
+	case FlatAST::GREATER: return " > ";
+	case FlatAST::GREATER_EQ: return " >= ";
+	default: return nullptr;
+	}
+}
+
+void FlatAST::unparse(std::ostream& out){
+	if (kinds.empty()){ return; }
+	unparseNode(out, 0, 0);
+}
+
+void FlatAST::unparseBody(std::ostream& out, uint32_t from, uint32_t to,
+	int indent
+){
+	for (uint32_t child = from; child < to; child = ends[child]){
+		unparseNode(out, child, indent);
+	}
+}
+
+//Like ExpNode::unparseNested: operators and assignments
+// are parenthesized, calls, lvals and literals are not
+void FlatAST::unparseNested(std::ostream& out, uint32_t node){
+	Kind k = kind(node);
+	bool parens = k == ASSIGN || k == NEG || k == NOT
+		|| binaryOp(k) != nullptr;
+	if (parens){ out << "("; }
+	unparseNode(out, node, 0);
+	if (parens){ out << ")"; }
+}
+
+void FlatAST::unparseNode(std::ostream& out, uint32_t node, int indent){
+	Kind k = kind(node);
+	uint32_t first = node + 1;
+	switch (k){
+	case PROGRAM:
+		unparseBody(out, first, ends[node], indent);
+		return;
+	case VAR_DECL:
+	case FORMAL_DECL:
+		doIndent(out, indent);
+		unparseNode(out, ends[first], 0);
+		out << ":";
+		unparseNode(out, first, 0);
+		if (k == VAR_DECL){ out << ";\n"; }
+		return;
+	case FN_DECL: {
+		uint32_t retType = ends[first];
+		uint32_t child = ends[retType];
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << ":";
+		unparseNode(out, retType, 0);
+		out << "(";
+		for (uint32_t i = 0; i < payloads[node]; i++){
+			if (i > 0){ out << ", "; }
+			unparseNode(out, child, 0);
+			child = ends[child];
+		}
+		out << ")";
+		out << "{\n";
+		unparseBody(out, child, ends[node], indent + 1);
+		doIndent(out, indent);
+		out << "}\n";
+		return;
+	}
+	case ASSIGN_STMT:
+	case CALL_STMT:
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << ";\n";
+		return;
+	case READ_STMT:
+		doIndent(out, indent);
+		out << "read ";
+		unparseNode(out, first, 0);
+		out << ";\n";
+		return;
+	case WRITE_STMT:
+		doIndent(out, indent);
+		out << "write ";
+		unparseNode(out, first, 0);
+		out << ";\n";
+		return;
+	case POST_DEC_STMT:
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << "--;\n";
+		return;
+	case POST_INC_STMT:
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << "++;\n";
+		return;
+	case IF_STMT:
+	case WHILE_STMT:
+		doIndent(out, indent);
+		out << (k == IF_STMT ? "if (" : "while (");
+		unparseNode(out, first, 0);
+		out << "){\n";
+		unparseBody(out, ends[first], ends[node], indent + 1);
+		doIndent(out, indent);
+		out << "}\n";
+		return;
+	case IF_ELSE_STMT: {
+		uint32_t child = ends[first];
+		doIndent(out, indent);
+		out << "if (";
+		unparseNode(out, first, 0);
+		out << "){\n";
+		for (uint32_t i = 0; i < payloads[node]; i++){
+			unparseNode(out, child, indent + 1);
+			child = ends[child];
+		}
+		doIndent(out, indent);
+		out << "} else {\n";
+		unparseBody(out, child, ends[node], indent + 1);
+		doIndent(out, indent);
+		out << "}\n";
+		return;
+	}
+	case RETURN_STMT:
+		doIndent(out, indent);
+		out << "return";
+		if (first < ends[node]){
+			out << " ";
+			unparseNode(out, first, 0);
+		}
+		out << ";\n";
+		return;
+	case ID: {
+		doIndent(out, indent);
+		out << name(node);
+		SemSymbol * sym = symbol(node);
+		if (sym != nullptr){
+			out << "(" << sym->getDataType()->getString() << ")";
+		}
+		return;
+	}
+	case INDEX:
+		doIndent(out, indent);
+		unparseNested(out, first);
+		out << "[";
+		unparseNode(out, ends[first], 0);
+		out << "]";
+		return;
+	case CALL: {
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << "(";
+		for (uint32_t arg = ends[first]; arg < ends[node]; arg = ends[arg]){
+			if (arg != ends[first]){ out << ", "; }
+			unparseNode(out, arg, 0);
+		}
+		out << ")";
+		return;
+	}
+	case ASSIGN:
+		doIndent(out, indent);
+		unparseNested(out, first);
+		out << " = ";
+		unparseNested(out, ends[first]);
+		return;
+	case PLUS: case MINUS: case TIMES: case DIVIDE: case AND: case OR:
+	case EQUALS: case NOT_EQUALS: case LESS: case LESS_EQ:
+	case GREATER: case GREATER_EQ:
+		doIndent(out, indent);
+		unparseNested(out, first);
+		out << binaryOp(k);
+		unparseNested(out, ends[first]);
+		return;
+	case NEG:
+	case NOT:
+		doIndent(out, indent);
+		out << (k == NEG ? "-" : "!");
+		unparseNested(out, first);
+		return;
+	case INT_LIT:
+		doIndent(out, indent);
+		out << static_cast<int>(payloads[node]);
+		return;
+	case STR_LIT:
+		doIndent(out, indent);
+		out << string(node);
+		return;
+	case TRUE:
+		doIndent(out, indent);
+		out << "true";
+		return;
+	case FALSE:
+		doIndent(out, indent);
+		out << "false";
+		return;
+	case HAVOC:
+		doIndent(out, indent);
+		out << "havoc";
+		return;
+	case VOID_TYPE:
+		doIndent(out, indent);
+		out << "void";
+		return;
+	case INT_TYPE:
+		doIndent(out, indent);
+		out << "int";
+		return;
+	case BOOL_TYPE:
+		doIndent(out, indent);
+		out << "bool";
+		return;
+	case BYTE_TYPE:
+		doIndent(out, indent);
+		out << "byte";
+		return;
+	case ARRAY_TYPE:
+		doIndent(out, indent);
+		unparseNode(out, first, 0);
+		out << " array[" << payloads[node] << "]";
+		return;
+	}
+	throw new InternalError("Unknown flat AST node kind");
+}
+
+//Name analysis
+
+//What TypeNode::getType() gives for a type node
+static DataType * flatType(const FlatAST * flat, uint32_t node){
+	switch (flat->kind(node)){
+	case FlatAST::VOID_TYPE: return BasicType::VOID();
+	case FlatAST::INT_TYPE: return BasicType::INT();
+	case FlatAST::BOOL_TYPE: return BasicType::BOOL();
+	case FlatAST::BYTE_TYPE: return BasicType::BYTE();
+	case FlatAST::ARRAY_TYPE: {
+		const BasicType * base = flatType(flat, node + 1)->asBasic();
+		return ArrayType::produce(base,
+			static_cast<int>(flat->payload(node)));
+	}
+	default:
+		throw new InternalError("Not a flat type node");
+	}
+}
+
+bool FlatAST::nameAnalysis(){
+	if (kinds.empty()){ return false; }
+	symbols.assign(kinds.size(), nullptr);
+	SymbolTable * symTab = new SymbolTable();
+	bool res = nameNode(symTab, 0);
+	delete symTab;
+	return res;
+}
+
+bool FlatAST::nameBody(SymbolTable * symTab, uint32_t from, uint32_t to){
+	bool result = true;
+	for (uint32_t child = from; child < to; child = ends[child]){
+		result = nameNode(symTab, child) && result;
+	}
+	return result;
+}
+
+bool FlatAST::nameVarDecl(SymbolTable * symTab, uint32_t node){
+	uint32_t typeNode = node + 1;
+	uint32_t idNode = ends[typeNode];
+	DataType * dataType = flatType(this, typeNode);
+
+	bool validType = dataType->validVarType();
+	if (!validType){
+		NameErr::badVarType(line(node), col(node));
+	}
+
+	uint32_t varID = payloads[idNode];
+	bool validName = !symTab->clash(varID);
+	if (!validName){
+		NameErr::multiDecl(line(idNode), col(idNode));
+	}
+
+	if (!validType || !validName){
+		return false;
+	}
+	StrRef varName = name(idNode);
+	symTab->insert(new VarSymbol(varName, varID, dataType));
+	symbols[idNode] = symTab->find(varID);
+	return true;
+}
+
+bool FlatAST::nameFnDecl(SymbolTable * symTab, uint32_t node){
+	uint32_t idNode = node + 1;
+	uint32_t retNode = ends[idNode];
+	uint32_t fnID = payloads[idNode];
+	StrRef fnName = name(idNode);
+	FunctionTimer timer(fnName);
+
+	ScopeTable * atFnScope = symTab->getCurrentScope();
+	symTab->enterScope();
+
+	bool validName = true;
+	if (atFnScope->clash(fnID)){
+		NameErr::multiDecl(line(idNode), col(idNode));
+		validName = false;
+	}
+
+	bool validFormals = true;
+	std::vector<const DataType *> formalTypes;
+	uint32_t child = ends[retNode];
+	for (uint32_t i = 0; i < payloads[node]; i++){
+		validFormals = nameVarDecl(symTab, child) && validFormals;
+		formalTypes.push_back(flatType(this, child + 1));
+		child = ends[child];
+	}
+
+	const DataType * retType = flatType(this, retNode);
+	FnType * dataType = FnType::produce(formalTypes, retType);
+	if (validName){
+		atFnScope->addFn(fnName, fnID, dataType);
+		symbols[idNode] = atFnScope->lookup(fnID);
+	}
+
+	bool validBody = nameBody(symTab, child, ends[node]);
+
+	symTab->leaveScope();
+	return validFormals && validName && validBody;
+}
+
+bool FlatAST::nameNode(SymbolTable * symTab, uint32_t node){
+	uint32_t first = node + 1;
+	switch (kind(node)){
+	case PROGRAM: {
+		symTab->enterScope();
+		bool res = nameBody(symTab, first, ends[node]);
+		symTab->leaveScope();
+		return res;
+	}
+	case VAR_DECL:
+	case FORMAL_DECL:
+		return nameVarDecl(symTab, node);
+	case FN_DECL:
+		return nameFnDecl(symTab, node);
+	case IF_STMT:
+	case WHILE_STMT: {
+		bool result = nameNode(symTab, first);
+		symTab->enterScope();
+		result = nameBody(symTab, ends[first], ends[node]) && result;
+		symTab->leaveScope();
+		return result;
+	}
+	case IF_ELSE_STMT: {
+		bool result = nameNode(symTab, first);
+		uint32_t child = ends[first];
+		symTab->enterScope();
+		for (uint32_t i = 0; i < payloads[node]; i++){
+			result = nameNode(symTab, child) && result;
+			child = ends[child];
+		}
+		symTab->leaveScope();
+		symTab->enterScope();
+		result = nameBody(symTab, child, ends[node]) && result;
+		symTab->leaveScope();
+		return result;
+	}
+	case ID: {
+		SemSymbol * sym = symTab->find(payloads[node]);
+		if (sym == nullptr){
+			return NameErr::undeclID(line(node), col(node));
+		}
+		symbols[node] = sym;
+		return true;
+	}
+	default:
+		//Everything else just checks its children, in order
+		return nameBody(symTab, first, ends[node]);
+	}
+}
+
+}
@@ -0,0 +1,124 @@
+#ifndef CRONA_FLAT_AST_HPP
+#define CRONA_FLAT_AST_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "source_buffer.hpp"
+#include "str_ref.hpp"
+
+namespace crona{
+
+class ProgramNode;
+class SemSymbol;
+class SymbolTable;
+
+//A compact encoding of a whole AST, for very large
+// programs: one entry per node in a few parallel arrays
+// (struct-of-arrays), with no vtables, pointers or child
+// lists. Nodes are stored in pre-order, so a node's first
+// child directly follows it, and end(n) (one past the last
+// node of n's subtree) is the index of its next sibling.
+//
+// Each kind has a fixed child layout:
+//   PROGRAM          decls...
+//   VAR_DECL         type, id
+//   FORMAL_DECL      type, id
+//   FN_DECL          id, retType, formals..., stmts...
+//                    (payload: number of formals)
+//   IF_STMT          cond, stmts...
+//   IF_ELSE_STMT     cond, trueStmts..., falseStmts...
+//                    (payload: number of trueStmts)
+//   WHILE_STMT       cond, stmts...
+//   RETURN_STMT      exp, or nothing
+//   CALL             id, args...
+//   INDEX            id, offset
+//   ARRAY_TYPE       baseType (payload: length)
+//   ID               (payload: Interner ID of the name)
+//   INT_LIT          (payload: the value)
+//   STR_LIT          (payload: index of the text)
+// and the other statements and operators have their
+// operands as children, in source order.
+class FlatAST{
+public:
+	enum Kind : uint8_t {
+		PROGRAM, VAR_DECL, FORMAL_DECL, FN_DECL,
+		ASSIGN_STMT, READ_STMT, WRITE_STMT, POST_DEC_STMT,
+		POST_INC_STMT, IF_STMT, IF_ELSE_STMT, WHILE_STMT,
+		RETURN_STMT, CALL_STMT,
+		ID, INDEX, CALL, ASSIGN,
+		PLUS, MINUS, TIMES, DIVIDE, AND, OR,
+		EQUALS, NOT_EQUALS, LESS, LESS_EQ, GREATER, GREATER_EQ,
+		NEG, NOT,
+		INT_LIT, STR_LIT, TRUE, FALSE, HAVOC,
+		VOID_TYPE, INT_TYPE, BOOL_TYPE, BYTE_TYPE, ARRAY_TYPE
+	};
+
+	//Encode a (parsed, not yet analyzed) AST
+	static FlatAST * build(ProgramNode * root);
+
+	//Append a node, whose children are the nodes appended
+	// until it is closed. Only used by build().
+	uint32_t open(Kind kind, uint32_t offset, uint32_t payload = 0);
+	void close(uint32_t node);
+	uint32_t addString(StrRef text);
+	void addName(uint32_t nameID, StrRef text);
+
+	size_t size() const { return kinds.size(); }
+	Kind kind(uint32_t node) const { return static_cast<Kind>(kinds[node]); }
+	uint32_t offset(uint32_t node) const { return offsets[node]; }
+	//Looked up in the active SourceBuffer
+	size_t line(uint32_t node) const {
+		return SourceBuffer::locate(offsets[node]).line;
+	}
+	size_t col(uint32_t node) const {
+		return SourceBuffer::locate(offsets[node]).col;
+	}
+	uint32_t end(uint32_t node) const { return ends[node]; }
+	uint32_t payload(uint32_t node) const { return payloads[node]; }
+	StrRef string(uint32_t node) const { return strs[payloads[node]]; }
+	//The name of an ID node
+	StrRef name(uint32_t node) const { return names[payloads[node]]; }
+	//The symbol name analysis bound an ID node to, if any
+	SemSymbol * symbol(uint32_t node) const;
+
+	//Bytes held by the encoding, including the symbol of
+	// every node once name analysis has run (but not the
+	// symbols themselves)
+	size_t bytes() const;
+
+	//The same passes as on the ASTNode tree, dispatched on
+	// each node's kind. Only these run over the flat form:
+	// type analysis and 3AC lowering need the tree, so
+	// --ast=flat is refused with -c and -a.
+	void unparse(std::ostream& out);
+	bool nameAnalysis();
+private:
+	FlatAST(){ }
+	FlatAST(const FlatAST&) = delete;
+	FlatAST& operator=(const FlatAST&) = delete;
+
+	void unparseNode(std::ostream& out, uint32_t node, int indent);
+	void unparseNested(std::ostream& out, uint32_t node);
+	void unparseBody(std::ostream& out, uint32_t from, uint32_t to,
+		int indent);
+	bool nameNode(SymbolTable * symTab, uint32_t node);
+	bool nameBody(SymbolTable * symTab, uint32_t from, uint32_t to);
+	bool nameVarDecl(SymbolTable * symTab, uint32_t node);
+	bool nameFnDecl(SymbolTable * symTab, uint32_t node);
+
+	std::vector<uint8_t> kinds;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> ends;
+	std::vector<uint32_t> payloads;
+	std::vector<StrRef> strs;
+	//Indexed by Interner ID, so that names can be had
+	// without going through the (locked) Interner
+	std::vector<StrRef> names;
+	//Indexed by node, filled in by nameAnalysis()
+	std::vector<SemSymbol *> symbols;
+};
+
+}
+
+#endif
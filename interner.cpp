@@ -0,0 +1,74 @@
+#include <cstring>
+#include "interner.hpp"
+
+namespace crona{
+
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+Interner& Interner::global(){
+	static Interner interner;
+	return interner;
+}
+
+uint32_t Interner::intern(StrRef text){
+	size_t hash = std::hash<StrRef>()(text);
+	Shard& shard = shards[hash % SHARD_COUNT];
+	std::lock_guard<std::mutex> guard(shard.lock);
+
+	auto found = shard.ids.find(text);
+	if (found != shard.ids.end()){ return found->second; }
+
+	//Copy the text into the shard's storage, which is never
+	// freed or moved, so the key stays valid
+	if (shard.chunkLeft < text.size()){
+		size_t size = text.size() > CHUNK_SIZE ? text.size() : CHUNK_SIZE;
+		shard.chunkPos = new char[size];
+		shard.chunks.push_back(shard.chunkPos);
+		shard.chunkLeft = size;
+	}
+	if (text.size() > 0){
+		memcpy(shard.chunkPos, text.data(), text.size());
+	}
+	StrRef stored(shard.chunkPos, text.size());
+	shard.chunkPos += text.size();
+	shard.chunkLeft -= text.size();
+
+	uint32_t id;
+	{
+		std::lock_guard<std::mutex> textGuard(textLock);
+		id = static_cast<uint32_t>(texts.size());
+		texts.push_back(stored);
+	}
+	shard.ids.emplace(stored, id);
+	return id;
+}
+
+StrRef Interner::text(uint32_t id){
+	std::lock_guard<std::mutex> guard(textLock);
+	return texts[id];
+}
+
+size_t Interner::size(){
+	std::lock_guard<std::mutex> guard(textLock);
+	return texts.size();
+}
+
+void Interner::resetIfIdle(size_t limit){
+	if (size() <= limit){ return; }
+	std::unique_lock<std::shared_timed_mutex> idle(users, std::try_to_lock);
+	if (!idle.owns_lock()){ return; }
+	for (Shard& shard : shards){
+		std::lock_guard<std::mutex> guard(shard.lock);
+		std::unordered_map<StrRef, uint32_t>().swap(shard.ids);
+		for (char * chunk : shard.chunks){
+			delete[] chunk;
+		}
+		shard.chunks.clear();
+		shard.chunkLeft = 0;
+		shard.chunkPos = nullptr;
+	}
+	std::lock_guard<std::mutex> textGuard(textLock);
+	std::deque<StrRef>().swap(texts);
+}
+
+}
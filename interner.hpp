@@ -0,0 +1,80 @@
+#ifndef CRONA_INTERNER_HPP
+#define CRONA_INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include "str_ref.hpp"
+
+namespace crona{
+
+//Maps each distinct identifier to a dense 32-bit ID, so
+// that the symbol table can key on integers instead of
+// hashing and comparing names. IDs are handed out in the
+// order identifiers are first seen, starting from 0, and
+// are shared by every compilation in the process (so the
+// interner is safe to use from several threads at once, as
+// --batch and --serve do).
+//
+// A compilation only needs its IDs while it runs, so a
+// long-lived process (the compile server) holds a Use for
+// each compilation and calls resetIfIdle between them, to
+// keep the interner from growing with every new identifier
+// it is ever sent.
+class Interner{
+public:
+	static Interner& global();
+
+	uint32_t intern(StrRef text);
+	//The text of an interned identifier, which lives as
+	// long as the interner does (or until it is reset)
+	StrRef text(uint32_t id);
+	size_t size();
+
+	//Held for as long as a compilation uses IDs, so that
+	// the interner is not reset under it
+	class Use{
+	public:
+		Use(Interner& interner) : lock(interner.users){ }
+	private:
+		std::shared_lock<std::shared_timed_mutex> lock;
+	};
+	//If more than limit identifiers have been interned and
+	// no Use is held, forget them all, freeing their text.
+	// IDs start from 0 again afterwards.
+	void resetIfIdle(size_t limit);
+private:
+	Interner(){ }
+	Interner(const Interner&) = delete;
+	Interner& operator=(const Interner&) = delete;
+
+	//Identifiers are spread over shards by hash, so that
+	// threads interning different names rarely wait on each
+	// other
+	static const size_t SHARD_COUNT = 16;
+	class Shard{
+	public:
+		Shard() : chunkLeft(0), chunkPos(nullptr){ }
+		std::mutex lock;
+		//Keys point into this shard's chunks
+		std::unordered_map<StrRef, uint32_t> ids;
+		std::vector<char *> chunks;
+		size_t chunkLeft;
+		char * chunkPos;
+	};
+	Shard shards[SHARD_COUNT];
+
+	//Indexed by ID. A deque, so that growing it never moves
+	// the entries
+	std::mutex textLock;
+	std::deque<StrRef> texts;
+
+	std::shared_timed_mutex users;
+};
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "ast.hpp"
+#include "errors.hpp"
+#include "token_stream.hpp"
+
+namespace crona{
+
+void ProgramNode::deferBodies(const TokenBuffer * tokens,
+	const std::vector<std::pair<size_t, size_t>>& decls
+){
+	size_t next = 0;
+	for (DeclNode * decl : myGlobals){
+		FnDeclNode * fn = decl->asFnDecl();
+		if (fn == nullptr){ continue; }
+		if (next >= decls.size()){
+			throw new InternalError("Function body was not skipped");
+		}
+		fn->deferBody(tokens, decls[next].first, decls[next].second);
+		next++;
+	}
+}
+
+bool ProgramNode::parseBodies(size_t& stoppedAt){
+	for (DeclNode * decl : myGlobals){
+		FnDeclNode * fn = decl->asFnDecl();
+		if (fn != nullptr && !fn->parseBody(&stoppedAt)){ return false; }
+	}
+	return true;
+}
+
+void FnDeclNode::deferBody(const TokenBuffer * tokens, size_t from,
+	size_t to
+){
+	myBodyTokens = tokens;
+	myBodyFrom = static_cast<uint32_t>(from);
+	myBodyTo = static_cast<uint32_t>(to);
+}
+
+bool FnDeclNode::parseBody(size_t * stoppedAt){
+	if (myBodyTokens == nullptr){ return myBodyOK; }
+	//A function's declaration is a program of its own, so
+	// the ordinary Parser will do
+	TokenSlice slice(myBodyTokens, myBodyFrom, myBodyTo);
+	myBodyTokens = nullptr;
+	ProgramNode * root = nullptr;
+	Parser parser(slice, &root);
+	if (parser.parse() != 0){
+		if (stoppedAt != nullptr){ *stoppedAt = slice.lastOffset(); }
+		myBodyOK = false;
+		return false;
+	}
+	FnDeclNode * whole = root->getGlobals().front()->asFnDecl();
+	myBody = whole->myBody;
+	return true;
+}
+
+}
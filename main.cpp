@@ -1,247 +1,100 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
 #include <string.h>
+#include <unistd.h>
+#include <vector>
 #include "errors.hpp"
 #include "scanner.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "session.hpp"
+#include "driver.hpp"
+#include "batch.hpp"
+#include "server.hpp"
 
 using namespace crona;
 
 static void usageAndDie(){
 	std::cerr << "Usage: cronac <infile>\n"
 	<< " [-t <tokensFile>]: Output tokens to <tokensFile>\n"
+	<< " [--format=bin]: Write the tokens in a compact binary form\n"
+	<< " [--tokens-from <file>]: Read binary tokens instead of scanning\n"
 	<< " [-p]: Parse the input to check syntax\n"
 	<< " [-u <unparseFile>]: Output canonical program form\n"
 	<< " [-n <nameFile>]: Perform name analysis\n"
 	<< " [-c]: Do type checking\n"
 	<< " [-a <3ACFile>]: Output program as 3-address code\n"
+	<< " [--cache]: Reuse 3AC of unchanged functions from earlier runs\n"
+	<< " [--cache-dir <dir>]: Same, keeping the cache in <dir>\n"
+	<< " [--emit-ast-cache]: Save the AST in the cache, for later runs\n"
+	<< "   with --cache or --cache-dir to load instead of parsing\n"
+	<< " [--time-report]: Print the time spent in each phase\n"
+	<< " [--time-report-json <file>]: Write the same as JSON\n"
+	<< " [--trace-out <file>]: Write a Chrome trace of the compiler\n"
+	<< " [--ast=flat]: Parse, unparse and name-analyze over the compact\n"
+	<< "   flat AST encoding (not with -c or -a)\n"
+	<< " [--scanner=fast]: Scan with the hand-written scanner instead\n"
+	<< "   of the flex one\n"
+	<< " [--scan-threads <n>]: Scan large inputs on <n> threads\n"
+	<< " [--parse-threads <n>]: Parse large inputs on <n> threads\n"
+	<< " [--lazy-bodies]: Parse function bodies only when needed (with\n"
+	<< "   -p alone, only declarations and signatures are checked)\n"
+	<< " [--parser=rd]: Parse with the hand-written parser instead of\n"
+	<< "   the bison one\n"
+	<< " [--analysis-threads <n>]: Check function bodies' names and\n"
+	<< "   types on <n> threads\n"
+	<< "   or: cronac --batch [-j <threads>] [--cache] [--trace-out <file>]\n"
+	<< "         <infile|@manifest>...\n"
+	<< " Compile every input X.crona to X.3ac on a worker pool\n"
+	<< "   or: cronac --serve <socket>\n"
+	<< " Run a compile server listening on <socket>\n"
+	<< "   or: cronac --client <socket> <infile> [options]\n"
+	<< " Same as cronac <infile> [options], compiled by the server\n"
 	;
 	exit(1);
 }
 
-static void writeTokenStream(const char * inPath, const char * outPath){
-	std::ifstream inStream(inPath);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream";
-		msg += inPath;
-		throw new crona::InternalError(msg.c_str());
-	}
-	if (outPath == nullptr){
-		std::string msg = "No tokens output file given";
-		throw new crona::InternalError(msg.c_str());
-	}
-
-	Scanner scanner(&inStream);
-	if (strcmp(outPath, "--") == 0){
-		scanner.outputTokens(std::cout);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new InternalError(msg.c_str());
-		}
-		scanner.outputTokens(outStream);
-		outStream.close();
-	}
-}
-
-static crona::ProgramNode * parse(const char * inFile){
-	std::ifstream inStream(inFile);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream ";
-		msg += inFile;
-		throw new InternalError(msg.c_str());
-	}
-
-	//This pointer will be set to the root of the
-	// AST after parsing
-	crona::ProgramNode * root = nullptr;
-
-	crona::Scanner scanner(&inStream);
-	crona::Parser parser(scanner, &root);
-
-	int errCode = parser.parse();
-	if (errCode != 0){ return nullptr; }
-
-	return root;
-}
-
-static void outputAST(ASTNode * ast, const char * outPath){
-	if (strcmp(outPath, "--") == 0){
-		ast->unparse(std::cout, 0);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new crona::InternalError(msg.c_str());
-		}
-		ast->unparse(outStream, 0);
-	}
-}
-
-static crona::NameAnalysis * doNameAnalysis(const char * inputPath){
-	crona::ProgramNode * ast = parse(inputPath);
-	if (ast == nullptr){ return nullptr; }
-	
-	return crona::NameAnalysis::build(ast);
-}
-
-static bool doUnparsing(const char * inputPath, const char * outPath){
-	crona::ProgramNode * ast = parse(inputPath);
-	if (ast == nullptr){ 
-		std::cerr << "No AST built\n";
-		return false;
-	}
-
-	outputAST(ast, outPath);
-	return true;
-}
-
-static crona::TypeAnalysis * doTypeAnalysis(const char * inputPath){
-	crona::NameAnalysis * nameAnalysis = doNameAnalysis(inputPath);
-	if (nameAnalysis == nullptr){ return nullptr; }
-	return TypeAnalysis::build(nameAnalysis);
-}
-
-static void write3AC(crona::IRProgram * prog, const char * outPath){
-	if (outPath == nullptr){
-		throw new InternalError("Null 3AC flat file given");
-	}
-	std::string flatProg = prog->toString();
-	if (strcmp(outPath, "--") == 0){
-		std::cout << flatProg << std::endl;
-	} else {
-		std::ofstream outStream(outPath);
-		outStream << flatProg << std::endl;
-		outStream.close();
-	}
-}
-
-
-static IRProgram * do3AC(const char * inputPath){
-	crona::TypeAnalysis * typeAnalysis = doTypeAnalysis(inputPath);
-	if (typeAnalysis == nullptr){ return nullptr; }
-	
-	IRProgram * prog = typeAnalysis->ast->to3AC(typeAnalysis);
-	return prog;
-}
-
 int 
 main( const int argc, const char **argv )
 {
 	if (argc <= 1){ usageAndDie(); }
-	std::ifstream * input = new std::ifstream(argv[1]);
-	if (input == nullptr){ usageAndDie(); }
-	if (!input->good()){
-		std::cerr << "Bad path " << argv[1] << std::endl;
-		usageAndDie();
+	if (strcmp(argv[1], "--batch") == 0){
+		std::vector<std::string> args(argv + 2, argv + argc);
+		return crona::BatchCompiler::run(args);
+	}
+	if (strcmp(argv[1], "--serve") == 0){
+		if (argc != 3){ usageAndDie(); }
+		return crona::CompileServer::serve(argv[2]);
 	}
 
-	const char * inFile = NULL;
-	const char * tokensFile = NULL;
-	bool checkParse = false;
-	const char * unparseFile = NULL;
-	const char * namesFile = NULL;
-	bool checkTypes = false;
-	const char * threeACFile = NULL;
-
-	bool useful = false;
-	int i = 1;
-	for (int i = 1 ; i < argc ; i++){
-		if (argv[i][0] == '-'){
-			if (argv[i][1] == 't'){
-				i++;
-				tokensFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'p'){
-				checkParse = true;
-				useful = true;
-			} else if (argv[i][1] == 'u'){
-				i++;
-				if (i >= argc){ usageAndDie(); }
-				unparseFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'n'){
-				i++;
-				namesFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'c'){
-				checkTypes = true;
-				useful = true;
-			} else if (argv[i][1] == 'a'){
-				i++;
-				if (i >= argc){ usageAndDie(); }
-				threeACFile = argv[i];
-				useful = true;
-			} else {
-				std::cerr << "Unrecognized argument: ";
-				std::cerr << argv[i] << std::endl;
-				usageAndDie();
-			}
-		} else {
-			if (inFile == NULL){
-				inFile = argv[i];
-			} else {
-				std::cerr << "Only 1 input file allowed";
-				std::cerr << argv[i] << std::endl;
-				usageAndDie();
-			}
-		}
+	//With --client, the rest of the command line is an
+	// ordinary cronac command line, run by the server
+	const char * serverPath = nullptr;
+	int cmdArgc = argc;
+	const char ** cmdArgv = argv;
+	if (strcmp(argv[1], "--client") == 0){
+		if (argc <= 3){ usageAndDie(); }
+		serverPath = argv[2];
+		cmdArgc = argc - 2;
+		cmdArgv = argv + 2;
 	}
-	if (inFile == NULL){
+
+	if (access(cmdArgv[1], R_OK) != 0){
+		std::cerr << "Bad path " << cmdArgv[1] << std::endl;
 		usageAndDie();
 	}
-	if (!useful){
-		std::cerr << "Hey, you didn't tell cronac to do anything!\n";
+
+	DriverOptions opts;
+	if (!opts.parse(cmdArgc, cmdArgv, std::cerr)){
 		usageAndDie();
 	}
 
-	try {
-		if (tokensFile != nullptr){
-			writeTokenStream(inFile, tokensFile);
-		}
-		if (checkParse){
-			if (!parse(inFile)){
-				std::cerr << "Parse failed" << std::endl;
-			}
-		}
-		if (unparseFile != nullptr){
-			doUnparsing(inFile, unparseFile);
-		}
-		if (namesFile){
-			crona::NameAnalysis * na;
-			na = doNameAnalysis(inFile);
-			if (na == nullptr){
-				std::cerr << "Name Analysis Failed\n";
-				return 1;
-			}
-			outputAST(na->ast, namesFile);
-		}
-		if (checkTypes){
-			crona::TypeAnalysis * ta;
-			ta = doTypeAnalysis(inFile);
-			if (ta == nullptr){
-				std::cerr << "Type Analysis Failed\n";
-				return 1;
-			}
-		}
-		if (threeACFile != nullptr){
-			auto prog = do3AC(inFile);
-			if (prog == nullptr){ return 1; }
-			write3AC(prog, threeACFile);
-		}
-	} catch (crona::ToDoError * e){
-		std::cerr << "ToDoError: " << e->msg() << "\n";
-		return 1;
-	} catch (crona::InternalError * e){
-		std::cerr << "InternalError: " << e->msg() << "\n";
-		return 1;
+	if (serverPath != nullptr){
+		return CompileClient::run(serverPath, opts, cmdArgc, cmdArgv);
 	}
 
-	return 0;
+	CompilationSession session(opts.inFile);
+	OutputFiles files;
+	return Driver::run(session, opts, files);
 }
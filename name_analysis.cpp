@@ -1,6 +1,7 @@
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "errName.hpp"
+#include "time_report.hpp"
 #include "types.hpp"
 
 namespace crona{
@@ -9,7 +10,7 @@ bool ProgramNode::nameAnalysis(SymbolTable * symTab){
 	//Enter the global scope
 	symTab->enterScope();
 	bool res = true;
-	for (auto decl : *myGlobals){
+	for (auto decl : myGlobals){
 		res = decl->nameAnalysis(symTab) && res;
 	}
 	//Leave the global scope
@@ -41,7 +42,7 @@ bool IfStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
@@ -52,12 +53,12 @@ bool IfElseStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
 	symTab->enterScope();
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
@@ -68,7 +69,7 @@ bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
 	result = myCond->nameAnalysis(symTab) && result;
 	symTab->enterScope();
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		result = stmt->nameAnalysis(symTab) && result;
 	}	
 	symTab->leaveScope();
@@ -77,14 +78,15 @@ bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
 
 bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	DataType * dataType = getTypeNode()->getType();
-	std::string varName = ID()->getName();
+	StrRef varName = ID()->getName();
 
 	bool validType = dataType->validVarType();
 	if (!validType){
 		NameErr::badVarType(line(), col()); 
 	}
 
-	bool validName = !symTab->clash(varName);
+	uint32_t varID = ID()->getNameID();
+	bool validName = !symTab->clash(varID);
 	if (!validName){ 
 		NameErr::multiDecl(ID()->line(), ID()->col()); 
 	}
@@ -92,62 +94,70 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	if (!validType || !validName){ 
 		return false; 
 	} else {
-		symTab->insert(new VarSymbol(varName, dataType));
-		SemSymbol * sym = symTab->find(varName);
+		symTab->insert(new VarSymbol(varName, varID, dataType));
+		SemSymbol * sym = symTab->find(varID);
 		this->myID->attachSymbol(sym);
 		return true;
 	}
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string fnName = this->ID()->getName();
+	FunctionTimer timer(this->ID()->getName());
+	bool validSignature = nameSignature(symTab);
+	bool validBody = nameBody(symTab);
+	return validSignature && validBody;
+}
 
+bool FnDeclNode::nameSignature(SymbolTable * symTab){
 	bool validRet = myRetType->nameAnalysis(symTab);
 
-	// hold onto the scope of the function.
-	ScopeTable * atFnScope = symTab->getCurrentScope();
-	//Enter a new scope for "within" this function.
-	ScopeTable * inFnScope = symTab->enterScope();
-
 	/*Note that we check for a clash of the function 
 	  name in it's declared scope (e.g. a global
 	  scope for a global function)
 	*/
+	ScopeTable * atFnScope = symTab->getCurrentScope();
 	bool validName = true;
-	if (atFnScope->clash(fnName)){
+	uint32_t fnID = this->ID()->getNameID();
+	if (atFnScope->clash(fnID)){
 		NameErr::multiDecl(ID()->line(), ID()->col()); 
 		validName = false;
 	}
 
-	bool validFormals = true;
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
-	for (auto formal : *(this->myFormals)){
-		validFormals = formal->nameAnalysis(symTab) && validFormals;
+	std::vector<const DataType *> formalTypes;
+	for (auto formal : myFormals){
 		TypeNode * typeNode = formal->getTypeNode();
 		const DataType * formalType = typeNode->getType();
-		formalTypes->push_back(formalType);
+		formalTypes.push_back(formalType);
 	}
 
-
 	const DataType * retType = this->getRetTypeNode()->getType();
-	FnType * dataType = new FnType(formalTypes, retType);
+	FnType * dataType = FnType::produce(formalTypes, retType);
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
 	if (validName){
-		atFnScope->addFn(fnName, dataType);
-		SemSymbol * sym = atFnScope->lookup(fnName);
+		atFnScope->addFn(this->ID()->getName(), fnID, dataType);
+		SemSymbol * sym = atFnScope->lookup(fnID);
 		this->myID->attachSymbol(sym);
-		
+	}
+	return validRet && validName;
+}
+
+bool FnDeclNode::nameBody(SymbolTable * symTab){
+	//Enter a new scope for "within" this function.
+	symTab->enterScope();
+
+	bool validFormals = true;
+	for (auto formal : myFormals){
+		validFormals = formal->nameAnalysis(symTab) && validFormals;
 	}
 
 	bool validBody = true;
-	for (auto stmt : *myBody){
+	for (auto stmt : body()){
 		validBody = stmt->nameAnalysis(symTab) && validBody;
 	}
 
 	symTab->leaveScope();
-	return (validRet && validFormals && validName && validBody);
+	return validFormals && validBody;
 }
 
 bool IndexNode::nameAnalysis(SymbolTable * symTab){
@@ -166,7 +176,7 @@ bool BinaryExpNode::nameAnalysis(SymbolTable * symTab){
 bool CallExpNode::nameAnalysis(SymbolTable* symTab){
 	bool result = true;
 	result = myID->nameAnalysis(symTab) && result;
-	for (auto arg : *myArgs){
+	for (auto arg : myArgs){
 		result = arg->nameAnalysis(symTab) && result;
 	}
 	return result;
@@ -223,8 +233,7 @@ bool FalseNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool IDNode::nameAnalysis(SymbolTable* symTab){
-	std::string myName = this->getName();
-	SemSymbol * sym = symTab->find(myName);
+	SemSymbol * sym = symTab->find(this->getNameID());
 	if (sym == nullptr){
 		return NameErr::undeclID(line(), col());
 	}
@@ -234,6 +243,8 @@ bool IDNode::nameAnalysis(SymbolTable* symTab){
 
 void IDNode::attachSymbol(SemSymbol * symbolIn){
 	this->mySymbol = symbolIn;
+	this->myDepth = symbolIn->getDepth();
+	this->mySlot = symbolIn->getSlot();
 }
 
 }
@@ -2,18 +2,28 @@
 #define CRONA_NAME_ANALYSIS
 
 #include "ast.hpp"
+#include "parallel_analysis.hpp"
 #include "symbol_table.hpp"
 
 namespace crona{
 
 class NameAnalysis{
 public:
-	static NameAnalysis * build(ProgramNode * astIn){
-		NameAnalysis * nameAnalysis = new NameAnalysis;
-		SymbolTable * symTab = new SymbolTable();
-		bool res = astIn->nameAnalysis(symTab);
-		delete symTab;
+	//With threads > 1, function bodies are analyzed on that
+	// many threads (see ParallelAnalysis)
+	static NameAnalysis * build(ProgramNode * astIn,
+		size_t threads = 1
+	){
+		bool res;
+		if (threads > 1){
+			res = ParallelAnalysis::names(astIn, threads);
+		} else {
+			SymbolTable * symTab = new SymbolTable();
+			res = astIn->nameAnalysis(symTab);
+			delete symTab;
+		}
 		if (!res){ return nullptr; }
+		NameAnalysis * nameAnalysis = new NameAnalysis;
 
 		nameAnalysis->ast = astIn;
 		return nameAnalysis;
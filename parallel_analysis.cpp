@@ -0,0 +1,189 @@
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include "parallel_analysis.hpp"
+#include "errors.hpp"
+#include "time_report.hpp"
+#include "trace.hpp"
+#include "type_analysis.hpp"
+#include "worker_pool.hpp"
+
+namespace crona{
+
+//Functions are handed out to threads this many at a time
+static const size_t RUN = 8;
+
+//Run work(job, i) for each of count functions on up to
+// threads threads, which take the functions in order, a run
+// of them at a time. job (below threads) tells which thread
+// is running. What function i reports goes in messages[i];
+// what it allocates ends up in the arena active here, and
+// the time it takes in the TimeReport active here, in the
+// order of the functions.
+static void eachFunction(size_t count, size_t threads,
+	const std::function<void(size_t, size_t)>& work,
+	std::vector<std::string>& messages
+){
+	size_t jobs = (count + RUN - 1) / RUN;
+	if (jobs > threads){ jobs = threads; }
+	if (jobs == 0){ return; }
+
+	Arena * arena = Arena::active();
+	std::vector<Arena> arenas(jobs);
+	Tracer * tracer = Tracer::active();
+	const SourceBuffer * source = SourceBuffer::active();
+	TimeReport * report = TimeReport::active();
+	std::vector<TimeReport *> reports(jobs, nullptr);
+	//The CPU time of each thread, and which rows of which
+	// thread's report each function recorded
+	std::vector<std::pair<Times, Times>> cpu(jobs);
+	std::vector<size_t> jobOf(count);
+	std::vector<std::pair<size_t, size_t>> rows(count);
+	std::atomic<size_t> next(0);
+	{
+		WorkerPool pool(jobs);
+		for (size_t j = 0; j < jobs; j++){
+			Arena * jobArena = arena == nullptr ? nullptr : &arenas[j];
+			if (report != nullptr){ reports[j] = report->fork(); }
+			TimeReport * jobReport = reports[j];
+			pool.submit([j, count, &work, &messages, &next, jobArena,
+			  tracer, source, jobReport, &cpu, &jobOf, &rows](){
+				std::ostringstream out;
+				std::ostringstream err;
+				Report::redirect(&err, &out);
+				Tracer::activate(tracer);
+				TimeReport::activate(jobReport);
+				SourceScope sourceScope(source);
+				ArenaScope arenaScope(jobArena);
+				if (jobReport != nullptr){ cpu[j].first = Times::now(); }
+				size_t from;
+				while ((from = next.fetch_add(RUN)) < count){
+					size_t to = from + RUN < count ? from + RUN : count;
+					for (size_t i = from; i < to; i++){
+						jobOf[i] = j;
+						if (jobReport != nullptr){
+							rows[i].first = jobReport->functionRows();
+						}
+						work(j, i);
+						if (jobReport != nullptr){
+							rows[i].second = jobReport->functionRows();
+						}
+						messages[i] = err.str();
+						err.str("");
+					}
+				}
+				if (jobReport != nullptr){ cpu[j].second = Times::now(); }
+				TimeReport::activate(nullptr);
+				Tracer::activate(nullptr);
+				Report::restore();
+			});
+		}
+		pool.wait();
+	}
+	if (report != nullptr){
+		for (size_t i = 0; i < count; i++){
+			report->mergeFunctions(reports[jobOf[i]], rows[i].first,
+				rows[i].second);
+		}
+		for (size_t j = 0; j < jobs; j++){
+			report->addCPU(cpu[j].first, cpu[j].second);
+			delete reports[j];
+		}
+	}
+	if (arena == nullptr){ return; }
+	for (Arena& jobArena : arenas){
+		arena->adopt(&jobArena);
+	}
+}
+
+bool ParallelAnalysis::names(ProgramNode * root, size_t threads){
+	Span<DeclNode *> decls = root->getGlobals();
+	SymbolTable globals;
+	globals.enterScope();
+
+	//The first pass, reporting what each declaration says
+	// about its own name into declared
+	bool res = true;
+	std::vector<std::string> declared(decls.size());
+	std::vector<FnDeclNode *> fns;
+	std::vector<size_t> asOf;
+	std::ostringstream messages;
+	std::ostream * errSink = &Report::err();
+	std::ostream * outSink = &Report::out();
+	Report::redirect(&messages, outSink);
+	try {
+		for (size_t i = 0; i < decls.size(); i++){
+			FnDeclNode * fn = decls[i]->asFnDecl();
+			if (fn == nullptr){
+				res = decls[i]->nameAnalysis(&globals) && res;
+			} else {
+				res = fn->nameSignature(&globals) && res;
+				fns.push_back(fn);
+				asOf.push_back(globals.snapshot());
+			}
+			declared[i] = messages.str();
+			messages.str("");
+		}
+	} catch (...){
+		Report::redirect(errSink, outSink);
+		throw;
+	}
+	Report::redirect(errSink, outSink);
+
+	//The second pass, over the bodies
+	std::vector<std::string> bodies(fns.size());
+	std::vector<char> ok(fns.size());
+	eachFunction(fns.size(), threads, [&](size_t, size_t i){
+		FunctionTimer timer(fns[i]->ID()->getName());
+		SymbolTable body(&globals, asOf[i]);
+		ok[i] = fns[i]->nameBody(&body);
+	}, bodies);
+
+	size_t fn = 0;
+	for (size_t i = 0; i < decls.size(); i++){
+		Report::emitLines(declared[i]);
+		if (decls[i]->asFnDecl() == nullptr){ continue; }
+		Report::emitLines(bodies[fn]);
+		res = ok[fn] && res;
+		fn++;
+	}
+	globals.leaveScope();
+	return res;
+}
+
+void ParallelAnalysis::types(ProgramNode * root, TypeAnalysis * typing,
+	size_t threads
+){
+	//Typing a global reports nothing, so the globals are
+	// typed first and only the functions' messages need
+	// putting in order
+	std::vector<FnDeclNode *> fns;
+	for (DeclNode * decl : root->getGlobals()){
+		FnDeclNode * fn = decl->asFnDecl();
+		if (fn == nullptr){
+			decl->typeAnalysis(typing);
+		} else {
+			fns.push_back(fn);
+		}
+	}
+
+	//Each thread types its functions with a fork of its own
+	std::vector<std::string> bodies(fns.size());
+	std::vector<TypeAnalysis *> parts(threads, nullptr);
+	eachFunction(fns.size(), threads, [&](size_t job, size_t i){
+		if (parts[job] == nullptr){ parts[job] = typing->fork(); }
+		fns[i]->typeAnalysis(parts[job]);
+	}, bodies);
+
+	for (const std::string& messages : bodies){
+		Report::emitLines(messages);
+	}
+	for (TypeAnalysis * part : parts){
+		if (part == nullptr){ continue; }
+		typing->merge(part);
+		delete part;
+	}
+	typing->nodeType(root, BasicType::VOID());
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef CRONA_PARALLEL_ANALYSIS_HPP
+#define CRONA_PARALLEL_ANALYSIS_HPP
+
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+namespace crona{
+
+class TypeAnalysis;
+
+//Name and type analysis with function bodies analyzed on
+// several threads at once. Inside a body, analysis only
+// reads what the globals and functions declared before it
+// bound, and only writes to the body's own nodes, so once
+// the top-level declarations have been seen in order, the
+// bodies can be analyzed in any order.
+//
+// Names are analyzed in two passes. The first walks the
+// declarations in order on the calling thread, binding the
+// globals and each function's name (see
+// FnDeclNode::nameSignature) and noting how far the global
+// scope had got at each function. The second analyzes the
+// bodies, each in a SymbolTable of its own opened on top of
+// the global scope as it was at that function, so a global
+// declared after a function is still undeclared in its body.
+// Type analysis needs no first pass: types go on the nodes
+// themselves, and each thread types its bodies with a
+// TypeAnalysis of its own (see TypeAnalysis::fork), so that
+// threads only share the types' flyweights.
+//
+// Each declaration's messages are held back and reported
+// once all the bodies are done, in the order of the
+// declarations, so they come out as they would from the
+// sequential analyses.
+class ParallelAnalysis{
+public:
+	//As root->nameAnalysis, on up to threads threads
+	static bool names(ProgramNode * root, size_t threads);
+	//As root->typeAnalysis(typing), on up to threads threads
+	static void types(ProgramNode * root, TypeAnalysis * typing,
+		size_t threads);
+};
+
+}
+
+#endif
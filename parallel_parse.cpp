@@ -0,0 +1,128 @@
+#include <sstream>
+#include "parallel_parse.hpp"
+#include "errors.hpp"
+#include "rd_parser.hpp"
+#include "time_report.hpp"
+#include "trace.hpp"
+#include "worker_pool.hpp"
+
+namespace crona{
+
+using TokenKind = crona::Parser::token;
+
+//What one thread made of its piece of the tokens
+class ParsedChunk{
+public:
+	ParsedChunk() : root(nullptr){ }
+	ProgramNode * root;
+	Arena arena;
+	//The CPU time of the thread that did the piece, if a
+	// TimeReport is active
+	std::pair<Times, Times> cpu;
+};
+
+std::vector<size_t> ParallelParse::cuts(const TokenBuffer * tokens,
+	size_t count
+){
+	std::vector<size_t> res;
+	res.push_back(0);
+	size_t size = tokens->size();
+	size_t target = size / count;
+	int depth = 0;
+	for (size_t i = 0; i < size && res.size() < count; i++){
+		int kind = tokens->at(i)->kind();
+		if (kind == TokenKind::LCURLY){
+			depth++;
+		} else if (kind == TokenKind::RCURLY){
+			depth--;
+		} else if (kind != TokenKind::SEMICOLON){
+			continue;
+		}
+		if (depth != 0 || i + 1 < target * res.size()){ continue; }
+		if (i + 1 < size){ res.push_back(i + 1); }
+	}
+	res.push_back(size);
+	return res;
+}
+
+static void parseChunk(const TokenBuffer * tokens, size_t from, size_t to,
+	bool lazyBodies, bool rdParser, ParsedChunk * chunk
+){
+	ArenaScope arenaScope(&chunk->arena);
+	if (rdParser){
+		RDParser rd(tokens, from, to, lazyBodies);
+		ProgramNode * root = rd.parse();
+		if (root == nullptr){ return; }
+		if (lazyBodies){ root->deferBodies(tokens, rd.skipped()); }
+		chunk->root = root;
+		return;
+	}
+	TokenSlice slice(tokens, from, to, lazyBodies);
+	ProgramNode * root = nullptr;
+	Parser parser(slice, &root);
+	if (parser.parse() != 0){ return; }
+	if (lazyBodies){ root->deferBodies(tokens, slice.skipped()); }
+	chunk->root = root;
+}
+
+ProgramNode * ParallelParse::parse(const TokenBuffer * tokens,
+	size_t threads, bool lazyBodies, bool rdParser, Arena * arena
+){
+	size_t count = tokens->size() / MIN_CHUNK;
+	if (count > threads){ count = threads; }
+	if (count < 1){ count = 1; }
+	std::vector<size_t> at = cuts(tokens, count);
+	size_t pieces = at.size() - 1;
+
+	std::vector<ParsedChunk> chunks(pieces);
+	Tracer * tracer = Tracer::active();
+	TimeReport * report = TimeReport::active();
+	bool timed = report != nullptr;
+	const SourceBuffer * source = SourceBuffer::active();
+	{
+		WorkerPool pool(pieces);
+		for (size_t i = 0; i < pieces; i++){
+			ParsedChunk * chunk = &chunks[i];
+			size_t from = at[i];
+			size_t to = at[i + 1];
+			pool.submit([tokens, from, to, lazyBodies, rdParser, chunk,
+			  tracer, timed, source](){
+				//A piece's syntax error may only be an artifact
+				// of where it was cut, so it is not reported
+				std::ostringstream out;
+				std::ostringstream err;
+				Report::redirect(&err, &out);
+				Tracer::activate(tracer);
+				SourceScope sourceScope(source);
+				if (timed){ chunk->cpu.first = Times::now(); }
+				{
+					PhaseTimer timer("parse chunk");
+					parseChunk(tokens, from, to, lazyBodies, rdParser,
+						chunk);
+				}
+				if (timed){ chunk->cpu.second = Times::now(); }
+				Tracer::activate(nullptr);
+				Report::restore();
+			});
+		}
+		pool.wait();
+	}
+	for (size_t i = 0; timed && i < pieces; i++){
+		report->addCPU(chunks[i].cpu.first, chunks[i].cpu.second);
+	}
+
+	for (ParsedChunk& chunk : chunks){
+		if (chunk.root == nullptr){ return nullptr; }
+	}
+	ArenaScope arenaScope(arena);
+	SpanBuilder<DeclNode *> globals;
+	for (ParsedChunk& chunk : chunks){
+		for (DeclNode * decl : chunk.root->getGlobals()){
+			globals.push_back(decl);
+		}
+		arena->adopt(&chunk.arena);
+	}
+	return new ProgramNode(globals.finish());
+}
+
+}
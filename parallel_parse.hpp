@@ -0,0 +1,48 @@
+#ifndef CRONA_PARALLEL_PARSE_HPP
+#define CRONA_PARALLEL_PARSE_HPP
+
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "token_stream.hpp"
+
+namespace crona{
+
+//Parses a large token stream on several threads at once. At
+// the top level a program is only a list of declarations,
+// each ending in either a semicolon (a variable) or the
+// closing curly brace of a function body, so outside of any
+// curly braces the tokens can be cut after either one. A run
+// of declarations is itself a program, so each piece is
+// parsed with the ordinary Parser, and the pieces'
+// declarations, put back together in order, are exactly
+// those of parsing the whole stream.
+//
+// The cuts are only right if the stream parses, so if any
+// piece fails to, parse() gives up and the caller should
+// parse the whole stream to report the error.
+class ParallelParse{
+public:
+	//Pieces with fewer tokens than this aren't worth a
+	// thread
+	static const size_t MIN_CHUNK = 64 * 1024;
+
+	//Parse tokens in up to threads pieces, into arena,
+	// deferring function bodies if lazyBodies is set (see
+	// TokenSlice), with an RDParser if rdParser is set and
+	// the bison Parser otherwise. Returns nullptr, having
+	// reported nothing, if any piece has a syntax error.
+	static ProgramNode * parse(const TokenBuffer * tokens, size_t threads,
+		bool lazyBodies, bool rdParser, Arena * arena);
+
+	//Where to cut tokens into (at most) count pieces of
+	// about the same size: the indices of the pieces' first
+	// tokens, each just after the end of a declaration,
+	// followed by the number of tokens
+	static std::vector<size_t> cuts(const TokenBuffer * tokens,
+		size_t count);
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include <cstring>
+#include <sstream>
+#include "parallel_scan.hpp"
+#include "errors.hpp"
+#include "fast_scanner.hpp"
+#include "scanner.hpp"
+#include "time_report.hpp"
+#include "trace.hpp"
+#include "worker_pool.hpp"
+
+namespace crona{
+
+//What one thread made of its piece of the input
+class ScannedChunk{
+public:
+	ScannedChunk() : tokens(nullptr){ }
+	TokenBuffer * tokens;
+	Arena arena;
+	std::string messages;
+	//The CPU time of the thread that did the piece, if a
+	// TimeReport is active
+	std::pair<Times, Times> cpu;
+};
+
+std::vector<size_t> ParallelScan::cuts(const SourceBuffer * source,
+	size_t count
+){
+	std::vector<size_t> res;
+	res.push_back(0);
+	size_t size = source->size();
+	for (size_t i = 1; i < count; i++){
+		size_t target = size / count * i;
+		if (target <= res.back()){ continue; }
+		const void * newline = memchr(source->data() + target, '\n',
+			size - target);
+		if (newline == nullptr){ break; }
+		size_t cut = static_cast<size_t>(
+			static_cast<const char *>(newline) - source->data()) + 1;
+		if (cut < size){ res.push_back(cut); }
+	}
+	res.push_back(size);
+	return res;
+}
+
+static void scanChunk(const SourceBuffer * source, size_t from, size_t to,
+	bool fast, ScannedChunk * chunk
+){
+	ArenaScope arenaScope(&chunk->arena);
+	chunk->tokens = new TokenBuffer();
+	if (fast){
+		FastScanner scanner(source, from, to);
+		scanner.fill(chunk->tokens);
+	} else {
+		SourceStream inStream(source, from, to);
+		Scanner scanner(&inStream, source, from);
+		scanner.fill(chunk->tokens);
+	}
+}
+
+TokenBuffer * ParallelScan::scan(const SourceBuffer * source,
+	size_t threads, bool fast, Arena * arena
+){
+	size_t count = source->size() / MIN_CHUNK;
+	if (count > threads){ count = threads; }
+	if (count < 1){ count = 1; }
+	std::vector<size_t> at = cuts(source, count);
+	size_t pieces = at.size() - 1;
+
+	std::vector<ScannedChunk> chunks(pieces);
+	Tracer * tracer = Tracer::active();
+	TimeReport * report = TimeReport::active();
+	bool timed = report != nullptr;
+	{
+		WorkerPool pool(pieces);
+		for (size_t i = 0; i < pieces; i++){
+			ScannedChunk * chunk = &chunks[i];
+			size_t from = at[i];
+			size_t to = at[i + 1];
+			pool.submit([source, from, to, fast, chunk, tracer, timed](){
+				//Hold messages back, to report them in order
+				std::ostringstream out;
+				std::ostringstream err;
+				Report::redirect(&err, &out);
+				Tracer::activate(tracer);
+				if (timed){ chunk->cpu.first = Times::now(); }
+				{
+					PhaseTimer timer("scan chunk");
+					scanChunk(source, from, to, fast, chunk);
+				}
+				if (timed){ chunk->cpu.second = Times::now(); }
+				Tracer::activate(nullptr);
+				Report::restore();
+				chunk->messages = err.str();
+			});
+		}
+		pool.wait();
+	}
+	for (size_t i = 0; timed && i < pieces; i++){
+		report->addCPU(chunks[i].cpu.first, chunks[i].cpu.second);
+	}
+
+	TokenBuffer * res = new TokenBuffer();
+	for (ScannedChunk& chunk : chunks){
+		Report::emitLines(chunk.messages);
+		res->append(chunk.tokens);
+		delete chunk.tokens;
+		arena->adopt(&chunk.arena);
+	}
+	res->setEnd(source->size());
+	return res;
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef CRONA_PARALLEL_SCAN_HPP
+#define CRONA_PARALLEL_SCAN_HPP
+
+#include <vector>
+#include "arena.hpp"
+#include "source_buffer.hpp"
+#include "token_stream.hpp"
+
+namespace crona{
+
+//Scans a large input on several threads at once. No token,
+// comment or string literal spans a line (even a malformed
+// string literal stops at the newline), so the scanner is
+// always between tokens right after a newline, and an input
+// can be cut after any newline and its pieces scanned
+// separately. The tokens of the pieces, put back together
+// in order, are exactly those of scanning the whole input,
+// and since tokens only record their offset, no piece needs
+// to know the line or column it starts at.
+class ParallelScan{
+public:
+	//Pieces smaller than this aren't worth a thread
+	static const size_t MIN_CHUNK = 256 * 1024;
+
+	//Scan source in up to threads pieces, with a FastScanner
+	// if fast is set and the flex Scanner otherwise. The
+	// tokens end up in arena. The scanners' messages are
+	// reported in the order the whole input would give them.
+	static TokenBuffer * scan(const SourceBuffer * source, size_t threads,
+		bool fast, Arena * arena);
+
+	//Where to cut source into (at most) count pieces of
+	// about the same size: the offsets of the pieces' starts,
+	// each just after a newline, followed by the size of
+	// source
+	static std::vector<size_t> cuts(const SourceBuffer * source,
+		size_t count);
+};
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "proc_cache.hpp"
+
+namespace crona{
+
+//Bump this whenever the 3AC output format changes, so that
+// stale entries are never reused
+static const char * CACHE_VERSION = "cronac-proc-cache-2";
+
+static uint64_t fnv1a(const char * text, size_t size, uint64_t hash){
+	for (size_t i = 0; i < size; i++){
+		hash ^= static_cast<unsigned char>(text[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//128 bits of hash, as two FNV-1a runs from different bases
+std::string ProcCache::digest(const char * text, size_t size){
+	char buf[33];
+	unsigned long long lo = fnv1a(text, size, 14695981039346656037ULL);
+	unsigned long long hi = fnv1a(text, size, 0x6c62272e07bb0142ULL);
+	snprintf(buf, sizeof(buf), "%016llx%016llx", hi, lo);
+	return std::string(buf);
+}
+
+bool ProcCache::makeDirs(const std::string& path){
+	for (size_t i = 1; i <= path.size(); i++){
+		if (i < path.size() && path[i] != '/'){ continue; }
+		std::string prefix = path.substr(0, i);
+		if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST){
+			return false;
+		}
+	}
+	return true;
+}
+
+static void writeField(std::ostream& out, const std::string& field){
+	out << field.size() << "\n" << field;
+}
+
+//Read a field written by writeField from an entry of size
+// bytes, refusing lengths that run past its end
+static bool readField(std::istream& in, size_t size, std::string& field){
+	size_t len;
+	if (!(in >> len)){ return false; }
+	if (in.get() != '\n'){ return false; }
+	std::streamoff at = in.tellg();
+	if (at < 0 || len > size - static_cast<size_t>(at)){ return false; }
+	field.assign(len, '\0');
+	if (len > 0 && !in.read(&field[0], static_cast<std::streamsize>(len))){
+		return false;
+	}
+	return true;
+}
+
+//A digest of a template's labels, strings and body, stored
+// at the end of its entry so that an entry damaged on disk
+// is not taken for a good one
+static std::string contentDigest(const ProcTemplate * tmpl){
+	std::ostringstream text;
+	text << tmpl->labelCount << "\n";
+	for (const std::string& str : tmpl->strings){
+		writeField(text, str);
+	}
+	writeField(text, tmpl->body);
+	std::string all = text.str();
+	return ProcCache::digest(all.data(), all.size());
+}
+
+//The template in an entry of size bytes for the function
+// name, or nullptr if the entry is not a good one
+static ProcTemplate * readTemplate(std::istream& in, size_t size,
+	const std::string& name
+){
+	std::string version;
+	std::string storedName;
+	size_t labelCount;
+	size_t stringCount;
+	if (!readField(in, size, version) || version != CACHE_VERSION){
+		return nullptr;
+	}
+	if (!readField(in, size, storedName) || storedName != name){
+		return nullptr;
+	}
+	//Each label and string takes at least a byte of the entry
+	if (!(in >> labelCount >> stringCount)
+	  || labelCount > size || stringCount > size){
+		return nullptr;
+	}
+
+	ProcTemplate * tmpl = new ProcTemplate(name);
+	tmpl->labelCount = labelCount;
+	for (size_t i = 0; i < stringCount; i++){
+		std::string str;
+		if (!readField(in, size, str)){
+			delete tmpl;
+			return nullptr;
+		}
+		tmpl->strings.push_back(str);
+	}
+	std::string sum;
+	if (!readField(in, size, tmpl->body) || !readField(in, size, sum)
+	  || sum != contentDigest(tmpl) || !tmpl->wellFormed()){
+		delete tmpl;
+		return nullptr;
+	}
+	return tmpl;
+}
+
+ProcCache::ProcCache(std::string dirIn)
+: dir(dirIn), myHits(0), myMisses(0), myStored(false){
+}
+
+ProcCache::~ProcCache(){
+	for (ProcTemplate * tmpl : loaded){
+		delete tmpl;
+	}
+}
+
+std::string ProcCache::defaultDir(){
+	const char * xdg = getenv("XDG_CACHE_HOME");
+	if (xdg != nullptr && xdg[0] != '\0'){
+		return std::string(xdg) + "/cronac";
+	}
+	const char * home = getenv("HOME");
+	if (home != nullptr && home[0] != '\0'){
+		return std::string(home) + "/.cache/cronac";
+	}
+	return ".cronac-cache";
+}
+
+std::string ProcCache::entryPath(const std::string& key){
+	return dir + "/" + key + ".proc";
+}
+
+void ProcCache::attach(ProgramNode * ast){
+	std::ostringstream sigs;
+	sigs << CACHE_VERSION << "\n";
+	for (DeclNode * decl : ast->getGlobals()){
+		FnDeclNode * fn = decl->asFnDecl();
+		if (fn == nullptr){
+			decl->unparse(sigs, 0);
+		} else {
+			fn->unparseSignature(sigs);
+			sigs << "\n";
+		}
+	}
+
+	for (DeclNode * decl : ast->getGlobals()){
+		FnDeclNode * fn = decl->asFnDecl();
+		if (fn == nullptr){ continue; }
+		std::ostringstream keyText;
+		keyText << sigs.str() << "\n";
+		fn->unparse(keyText, 0);
+		std::string text = keyText.str();
+		std::string key = digest(text.data(), text.size());
+		std::string name = fn->ID()->getName().str();
+
+		ProcTemplate * tmpl = load(key, name);
+		if (tmpl == nullptr){
+			myMisses++;
+			pending[name] = key;
+		} else {
+			myHits++;
+			loaded.push_back(tmpl);
+			fn->useTemplate(tmpl);
+		}
+	}
+}
+
+void ProcCache::store(IRProgram * prog){
+	myStored = true;
+	if (pending.empty()){ return; }
+	if (!makeDirs(dir)){ return; }
+	for (Procedure * proc : *prog->getProcs()){
+		if (proc->isSpliced()){ continue; }
+		auto found = pending.find(proc->getName());
+		if (found == pending.end()){ continue; }
+		ProcTemplate * tmpl = prog->makeTemplate(proc);
+		save(found->second, tmpl);
+		delete tmpl;
+	}
+	pending.clear();
+}
+
+ProcTemplate * ProcCache::load(const std::string& key,
+	const std::string& name
+){
+	std::string path = entryPath(key);
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0){ return nullptr; }
+	std::ifstream in(path, std::ios::binary);
+	if (!in.good()){ return nullptr; }
+
+	ProcTemplate * tmpl = readTemplate(in,
+		static_cast<size_t>(info.st_size), name);
+	if (tmpl == nullptr){
+		//A damaged entry is a miss, and is removed so that
+		// store() can replace it
+		unlink(path.c_str());
+	}
+	return tmpl;
+}
+
+void ProcCache::save(const std::string& key, const ProcTemplate * tmpl){
+	//Write to a private file and rename it into place, so
+	// that concurrent compilations (--batch, --serve) never
+	// see a half-written entry
+	std::string path = entryPath(key);
+	std::string tmpPath = path + ".XXXXXX";
+	int fd = mkstemp(&tmpPath[0]);
+	if (fd < 0){ return; }
+	close(fd);
+
+	std::ofstream out(tmpPath, std::ios::binary);
+	writeField(out, CACHE_VERSION);
+	writeField(out, tmpl->name);
+	out << tmpl->labelCount << "\n" << tmpl->strings.size() << "\n";
+	for (const std::string& str : tmpl->strings){
+		writeField(out, str);
+	}
+	writeField(out, tmpl->body);
+	writeField(out, contentDigest(tmpl));
+	out.close();
+	if (!out.good() || rename(tmpPath.c_str(), path.c_str()) != 0){
+		unlink(tmpPath.c_str());
+	}
+}
+
+}
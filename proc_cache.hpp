@@ -0,0 +1,69 @@
+#ifndef CRONA_PROC_CACHE_HPP
+#define CRONA_PROC_CACHE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "3ac.hpp"
+
+namespace crona{
+
+//An on-disk cache of the 3AC for individual functions, so
+// that recompiling a program in which most functions are
+// unchanged only re-checks and re-lowers the ones that did
+// change.
+//
+// A function's entry is keyed by a hash of its name-analyzed
+// unparse (which pins down the type of every identifier it
+// uses) together with the signatures of every global
+// declaration, in order. Anything that could change the
+// function's type checking or 3AC changes the key.
+//
+// Entries are only written for programs that made it all
+// the way through to 3AC, so a cache hit means the function
+// type checked when it was stored.
+class ProcCache{
+public:
+	ProcCache(std::string dirIn);
+	~ProcCache();
+
+	//$XDG_CACHE_HOME/cronac, or ~/.cache/cronac
+	static std::string defaultDir();
+	//A 128-bit hash of text, in hex, as used for keys (also
+	// by ASTCache)
+	static std::string digest(const char * text, size_t size);
+	//mkdir -p
+	static bool makeDirs(const std::string& path);
+
+	//Attach the cached 3AC of every function of a name-
+	// analyzed program that has an entry
+	void attach(ProgramNode * ast);
+	//Write entries for the functions that attach() missed
+	void store(IRProgram * prog);
+
+	size_t hits() const { return myHits; }
+	size_t misses() const { return myMisses; }
+	//Whether store() has run, i.e. a program got as far as
+	// being lowered with this cache
+	bool stored() const { return myStored; }
+private:
+	std::string entryPath(const std::string& key);
+	ProcTemplate * load(const std::string& key, const std::string& name);
+	void save(const std::string& key, const ProcTemplate * tmpl);
+
+	std::string dir;
+	size_t myHits;
+	size_t myMisses;
+	bool myStored;
+	//Functions that missed, by name, with the key to
+	// store them under
+	std::map<std::string, std::string> pending;
+	//Templates handed out by attach(), which must stay
+	// alive until the program has been lowered
+	std::vector<ProcTemplate *> loaded;
+};
+
+}
+
+#endif
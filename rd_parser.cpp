@@ -0,0 +1,397 @@
+#include "rd_parser.hpp"
+
+namespace crona{
+
+using TokenKind = crona::Parser::token;
+
+//Deeper nesting than this is left to the bison Parser, whose
+// stack is on the heap, rather than risk running out of
+// (possibly a worker thread's) stack
+static const size_t MAX_DEPTH = 2000;
+
+//Thrown to unwind out of the parse at a syntax error
+class SyntaxFailure{ };
+
+//Counts one level of nesting for as long as it lives
+class DepthGuard{
+public:
+	DepthGuard(size_t& depthIn) : depth(depthIn){
+		if (++depth > MAX_DEPTH){ throw SyntaxFailure(); }
+	}
+	~DepthGuard(){ depth--; }
+private:
+	size_t& depth;
+};
+
+//crona.yy's precedence levels for the binary operators, from
+// loosest to tightest, or 0 for a token that isn't one. NOT
+// binds tighter than all of them, and ASSIGN looser.
+static const int PREC_OR = 1;
+static const int PREC_AND = 2;
+static const int PREC_COMPARE = 3;
+static const int PREC_ADD = 4;
+static const int PREC_MULT = 5;
+static const int PREC_NOT = 6;
+
+static int binaryPrec(int kind){
+	switch (kind){
+	case TokenKind::OR: return PREC_OR;
+	case TokenKind::AND: return PREC_AND;
+	case TokenKind::LESS:
+	case TokenKind::GREATER:
+	case TokenKind::LESSEQ:
+	case TokenKind::GREATEREQ:
+	case TokenKind::EQUALS:
+	case TokenKind::NOTEQUALS: return PREC_COMPARE;
+	case TokenKind::DASH:
+	case TokenKind::CROSS: return PREC_ADD;
+	case TokenKind::STAR:
+	case TokenKind::SLASH: return PREC_MULT;
+	default: return 0;
+	}
+}
+
+static ExpNode * binary(int kind, uint32_t offset, ExpNode * lhs,
+	ExpNode * rhs
+){
+	switch (kind){
+	case TokenKind::OR: return new OrNode(offset, lhs, rhs);
+	case TokenKind::AND: return new AndNode(offset, lhs, rhs);
+	case TokenKind::LESS: return new LessNode(offset, lhs, rhs);
+	case TokenKind::GREATER: return new GreaterNode(offset, lhs, rhs);
+	case TokenKind::LESSEQ: return new LessEqNode(offset, lhs, rhs);
+	case TokenKind::GREATEREQ: return new GreaterEqNode(offset, lhs, rhs);
+	case TokenKind::EQUALS: return new EqualsNode(offset, lhs, rhs);
+	case TokenKind::NOTEQUALS: return new NotEqualsNode(offset, lhs, rhs);
+	case TokenKind::DASH: return new MinusNode(offset, lhs, rhs);
+	case TokenKind::CROSS: return new PlusNode(offset, lhs, rhs);
+	case TokenKind::STAR: return new TimesNode(offset, lhs, rhs);
+	case TokenKind::SLASH: return new DivideNode(offset, lhs, rhs);
+	}
+	throw new InternalError("Not a binary operator");
+}
+
+RDParser::RDParser(const TokenBuffer * tokensIn, size_t from, size_t to,
+	bool skipBodiesIn)
+: tokens(tokensIn), myNext(from), myEnd(to), skipBodies(skipBodiesIn),
+  declStart(from), depth(0){
+}
+
+ProgramNode * RDParser::parse(){
+	try {
+		SpanBuilder<DeclNode *> globals;
+		while (myNext < myEnd){
+			globals.push_back(decl());
+		}
+		return new ProgramNode(globals.finish());
+	} catch (SyntaxFailure&){
+		return nullptr;
+	}
+}
+
+int RDParser::peek() const {
+	if (myNext >= myEnd){ return TokenKind::END; }
+	return tokens->at(myNext)->kind();
+}
+
+int RDParser::peekAt(size_t ahead) const {
+	if (myNext + ahead >= myEnd){ return TokenKind::END; }
+	return tokens->at(myNext + ahead)->kind();
+}
+
+Token * RDParser::take(){
+	if (myNext >= myEnd){ fail(); }
+	return tokens->at(myNext++);
+}
+
+Token * RDParser::expect(int kind){
+	if (peek() != kind){ fail(); }
+	return take();
+}
+
+void RDParser::fail() const {
+	throw SyntaxFailure();
+}
+
+//decl : varDecl SEMICOLON | fnDecl, where both start with
+// id COLON type
+DeclNode * RDParser::decl(){
+	declStart = myNext;
+	IDNode * declID = id();
+	expect(TokenKind::COLON);
+	TypeNode * declType = type();
+	if (peek() == TokenKind::SEMICOLON){
+		take();
+		return new VarDeclNode(declID->offset(), declType, declID);
+	}
+	return fnDecl(declID, declType);
+}
+
+TypeNode * RDParser::type(){
+	Token * tok = take();
+	uint32_t offset = tok->offset();
+	TypeNode * prim;
+	switch (tok->kind()){
+	case TokenKind::INT:
+		prim = new IntTypeNode(offset);
+		break;
+	case TokenKind::BOOL:
+		prim = new BoolTypeNode(offset);
+		break;
+	case TokenKind::BYTE:
+		prim = new ByteTypeNode(offset);
+		break;
+	case TokenKind::STRING:
+		return new ArrayTypeNode(offset, new ByteTypeNode(offset), 0);
+	case TokenKind::VOID:
+		return new VoidTypeNode(offset);
+	default:
+		fail();
+	}
+	if (peek() != TokenKind::ARRAY){ return prim; }
+	take();
+	expect(TokenKind::LBRACE);
+	auto len = static_cast<IntLitToken *>(expect(TokenKind::INTLITERAL));
+	expect(TokenKind::RBRACE);
+	return new ArrayTypeNode(offset, prim, static_cast<size_t>(len->num()));
+}
+
+FnDeclNode * RDParser::fnDecl(IDNode * fnID, TypeNode * retType){
+	SpanBuilder<FormalDeclNode *> formals;
+	expect(TokenKind::LPAREN);
+	if (peek() != TokenKind::RPAREN){
+		while (true){
+			IDNode * formalID = id();
+			expect(TokenKind::COLON);
+			TypeNode * formalType = type();
+			formals.push_back(new FormalDeclNode(formalID->offset(),
+				formalType, formalID));
+			if (peek() != TokenKind::COMMA){ break; }
+			take();
+		}
+	}
+	expect(TokenKind::RPAREN);
+	SpanBuilder<StmtNode *> body;
+	fnBody(body);
+	return new FnDeclNode(fnID->offset(), fnID, retType, formals.finish(),
+		body.finish());
+}
+
+void RDParser::fnBody(SpanBuilder<StmtNode *>& body){
+	if (skipBodies && peek() == TokenKind::LCURLY){
+		//Skip to the matching brace, if there is one, as
+		// TokenSlice would
+		int level = 1;
+		for (size_t i = myNext + 1; i < myEnd; i++){
+			int inner = tokens->at(i)->kind();
+			if (inner == TokenKind::LCURLY){
+				level++;
+			} else if (inner == TokenKind::RCURLY && --level == 0){
+				mySkipped.push_back(std::make_pair(declStart, i + 1));
+				myNext = i + 1;
+				return;
+			}
+		}
+	}
+	block(body);
+}
+
+//LCURLY stmtList RCURLY
+void RDParser::block(SpanBuilder<StmtNode *>& stmts){
+	DepthGuard guard(depth);
+	expect(TokenKind::LCURLY);
+	while (peek() != TokenKind::RCURLY){
+		stmts.push_back(stmt());
+	}
+	take();
+}
+
+StmtNode * RDParser::stmt(){
+	Token * tok;
+	switch (peek()){
+	case TokenKind::READ: {
+		tok = take();
+		LValNode * dst = lval(id());
+		expect(TokenKind::SEMICOLON);
+		return new ReadStmtNode(tok->offset(), dst);
+	}
+	case TokenKind::WRITE: {
+		tok = take();
+		ExpNode * src = exp();
+		expect(TokenKind::SEMICOLON);
+		return new WriteStmtNode(tok->offset(), src);
+	}
+	case TokenKind::IF: {
+		tok = take();
+		expect(TokenKind::LPAREN);
+		ExpNode * cond = exp();
+		expect(TokenKind::RPAREN);
+		SpanBuilder<StmtNode *> thens;
+		block(thens);
+		if (peek() != TokenKind::ELSE){
+			return new IfStmtNode(tok->offset(), cond, thens.finish());
+		}
+		take();
+		SpanBuilder<StmtNode *> elses;
+		block(elses);
+		return new IfElseStmtNode(tok->offset(), cond, thens.finish(),
+			elses.finish());
+	}
+	case TokenKind::WHILE: {
+		tok = take();
+		expect(TokenKind::LPAREN);
+		ExpNode * cond = exp();
+		expect(TokenKind::RPAREN);
+		SpanBuilder<StmtNode *> body;
+		block(body);
+		return new WhileStmtNode(tok->offset(), cond, body.finish());
+	}
+	case TokenKind::RETURN: {
+		tok = take();
+		ExpNode * res = nullptr;
+		if (peek() != TokenKind::SEMICOLON){ res = exp(); }
+		expect(TokenKind::SEMICOLON);
+		return new ReturnStmtNode(tok->offset(), res);
+	}
+	case TokenKind::ID:
+		break;
+	default:
+		fail();
+	}
+
+	//The rest start with an id: a declaration if a colon
+	// follows, a call if a parenthesis does, and otherwise an
+	// lval to assign, increment or decrement
+	StmtNode * res;
+	if (peekAt(1) == TokenKind::COLON){
+		IDNode * declID = id();
+		take();
+		TypeNode * declType = type();
+		res = new VarDeclNode(declID->offset(), declType, declID);
+	} else if (peekAt(1) == TokenKind::LPAREN){
+		CallExpNode * call = callExp(id());
+		res = new CallStmtNode(call->offset(), call);
+	} else {
+		LValNode * dst = lval(id());
+		tok = take();
+		switch (tok->kind()){
+		case TokenKind::ASSIGN: {
+			auto assign = new AssignExpNode(tok->offset(), dst, exp());
+			res = new AssignStmtNode(assign->offset(), assign);
+			break;
+		}
+		case TokenKind::DASHDASH:
+			res = new PostDecStmtNode(tok->offset(), dst);
+			break;
+		case TokenKind::CROSSCROSS:
+			res = new PostIncStmtNode(tok->offset(), dst);
+			break;
+		default:
+			fail();
+		}
+	}
+	expect(TokenKind::SEMICOLON);
+	return res;
+}
+
+//Precedence climbing: the binary operators at minPrec or
+// tighter. The comparisons are %nonassoc, so one can't take
+// another comparison as its left operand.
+ExpNode * RDParser::exp(int minPrec){
+	DepthGuard guard(depth);
+	ExpNode * lhs = unary();
+	bool compared = false;
+	while (true){
+		int kind = peek();
+		int prec = binaryPrec(kind);
+		if (prec < minPrec || prec == 0){ return lhs; }
+		if (prec == PREC_COMPARE && compared){ fail(); }
+		compared = prec == PREC_COMPARE;
+		uint32_t offset = take()->offset();
+		ExpNode * rhs = exp(prec + 1);
+		lhs = binary(kind, offset, lhs, rhs);
+	}
+}
+
+//An operand of the binary operators: NOT exp, which binds
+// tighter than any of them, DASH term, an assignment, whose
+// right side takes all the operators after it, or a term
+ExpNode * RDParser::unary(){
+	Token * tok;
+	switch (peek()){
+	case TokenKind::NOT:
+		tok = take();
+		return new NotNode(tok->offset(), exp(PREC_NOT));
+	case TokenKind::DASH:
+		tok = take();
+		return new NegNode(tok->offset(), term());
+	case TokenKind::ID: {
+		if (peekAt(1) == TokenKind::LPAREN){ return callExp(id()); }
+		LValNode * dst = lval(id());
+		if (peek() != TokenKind::ASSIGN){ return dst; }
+		tok = take();
+		return new AssignExpNode(tok->offset(), dst, exp());
+	}
+	default:
+		return term();
+	}
+}
+
+ExpNode * RDParser::term(){
+	if (peek() == TokenKind::ID){
+		if (peekAt(1) == TokenKind::LPAREN){ return callExp(id()); }
+		return lval(id());
+	}
+	Token * tok = take();
+	switch (tok->kind()){
+	case TokenKind::INTLITERAL:
+		return new IntLitNode(tok->offset(),
+			static_cast<IntLitToken *>(tok)->num());
+	case TokenKind::STRLITERAL:
+		return new StrLitNode(tok->offset(),
+			static_cast<StrToken *>(tok)->str());
+	case TokenKind::TRUE:
+		return new TrueNode(tok->offset());
+	case TokenKind::FALSE:
+		return new FalseNode(tok->offset());
+	case TokenKind::HAVOC:
+		return new HavocNode(tok->offset());
+	case TokenKind::LPAREN: {
+		ExpNode * inner = exp();
+		expect(TokenKind::RPAREN);
+		return inner;
+	}
+	}
+	fail();
+}
+
+CallExpNode * RDParser::callExp(IDNode * fnID){
+	expect(TokenKind::LPAREN);
+	if (peek() == TokenKind::RPAREN){
+		take();
+		return new CallExpNode(fnID->offset(), fnID, Span<ExpNode *>());
+	}
+	SpanBuilder<ExpNode *> args;
+	while (true){
+		args.push_back(exp());
+		if (peek() != TokenKind::COMMA){ break; }
+		take();
+	}
+	expect(TokenKind::RPAREN);
+	return new CallExpNode(fnID->offset(), fnID, args.finish());
+}
+
+LValNode * RDParser::lval(IDNode * lvalID){
+	if (peek() != TokenKind::LBRACE){ return lvalID; }
+	take();
+	ExpNode * index = exp();
+	expect(TokenKind::RBRACE);
+	return new IndexNode(lvalID->offset(), lvalID, index);
+}
+
+IDNode * RDParser::id(){
+	auto tok = static_cast<IDToken *>(expect(TokenKind::ID));
+	return new IDNode(tok->offset(), tok->value(), tok->id());
+}
+
+}
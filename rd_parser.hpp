@@ -0,0 +1,70 @@
+#ifndef CRONA_RD_PARSER_HPP
+#define CRONA_RD_PARSER_HPP
+
+#include <utility>
+#include <vector>
+#include "ast.hpp"
+#include "token_stream.hpp"
+
+namespace crona{
+
+//A hand-written recursive-descent parser for the same
+// grammar as the bison Parser (crona.yy), for --parser=rd.
+// Statements and declarations are told apart by at most two
+// tokens of lookahead, and expressions are parsed by
+// precedence climbing with crona.yy's precedence table, so
+// the AST is node for node the one Parser builds. It reads a
+// TokenBuffer directly rather than pulling tokens through a
+// TokenStream.
+//
+// It reports nothing: on a syntax error (or nesting too deep
+// to recurse through) parse() returns nullptr, and the caller
+// should run the bison Parser over the same tokens to report
+// the error in the usual words.
+class RDParser{
+public:
+	//Parse the tokens of tokens from index from up to (not
+	// including) to. With skipBodies set, function bodies are
+	// skipped as by TokenSlice, and each function's whole
+	// declaration is kept in skipped().
+	RDParser(const TokenBuffer * tokensIn, size_t from, size_t to,
+		bool skipBodiesIn = false);
+	//The program, in the active arena, or nullptr if the
+	// tokens don't parse
+	ProgramNode * parse();
+	const std::vector<std::pair<size_t, size_t>>& skipped() const {
+		return mySkipped;
+	}
+private:
+	int peek() const;
+	int peekAt(size_t ahead) const;
+	Token * take();
+	Token * expect(int kind);
+	[[noreturn]] void fail() const;
+
+	DeclNode * decl();
+	TypeNode * type();
+	FnDeclNode * fnDecl(IDNode * id, TypeNode * retType);
+	void fnBody(SpanBuilder<StmtNode *>& body);
+	void block(SpanBuilder<StmtNode *>& stmts);
+	StmtNode * stmt();
+	ExpNode * exp(int minPrec = 1);
+	ExpNode * unary();
+	ExpNode * term();
+	CallExpNode * callExp(IDNode * id);
+	LValNode * lval(IDNode * id);
+	IDNode * id();
+
+	const TokenBuffer * tokens;
+	size_t myNext;
+	size_t myEnd;
+	bool skipBodies;
+	//Where the declaration being parsed starts
+	size_t declStart;
+	size_t depth;
+	std::vector<std::pair<size_t, size_t>> mySkipped;
+};
+
+}
+
+#endif
@@ -12,9 +12,10 @@ void Scanner::outputTokens(std::ostream& outstream){
 	while(true){
 		tokenKind = this->yylex(&lexeme);
 		if (tokenKind == TokenKind::END){
+			LineCol end = source->position(srcOffset);
 			outstream << "EOF" 
-			  << " [" << this->lineNum 
-			  << "," << this->colNum << "]"
+			  << " [" << end.line 
+			  << "," << end.col << "]"
 			  << std::endl;
 			return;
 		} else {
@@ -23,3 +24,16 @@ void Scanner::outputTokens(std::ostream& outstream){
 		}
 	}
 }
+
+void Scanner::fill(TokenBuffer * buffer){
+	Lexeme lexeme;
+	int tokenKind;
+	while(true){
+		tokenKind = this->yylex(&lexeme);
+		if (tokenKind == TokenKind::END){
+			buffer->setEnd(srcOffset);
+			return;
+		}
+		buffer->push(lexeme.transToken);
+	}
+}
@@ -7,19 +7,27 @@
 
 #include "grammar.hh"
 #include "errors.hpp"
+#include "token_stream.hpp"
+#include "source_buffer.hpp"
+#include "interner.hpp"
 
 using TokenKind = crona::Parser::token;
 
 namespace crona{
 
-class Scanner : public yyFlexLexer{
+class Scanner : public yyFlexLexer, public TokenStream{
 public:
    
-   Scanner(std::istream *in) : yyFlexLexer(in)
+   //in must deliver exactly the text of source from 
+   // startOffset on, which identifier and string tokens 
+   // point into
+   Scanner(std::istream *in, const SourceBuffer * sourceIn,
+	size_t startOffset = 0) 
+   : yyFlexLexer(in), source(sourceIn)
    {
-	lineNum = 1;
-	colNum = 1;
 	hasError = false;
+	srcOffset = startOffset;
+	tokenStart = startOffset;
    };
    virtual ~Scanner() {
    };
@@ -28,65 +36,83 @@ public:
    using FlexLexer::yylex;
 
    // YY_DECL defined in the flex crona.l
-   virtual int yylex( crona::Parser::semantic_type * const lval);
+   virtual int yylex( crona::Parser::semantic_type * const lval) override;
+
+   //The text of the current match, in the source buffer
+   StrRef lexeme(){
+	return StrRef(source->data() + tokenStart,
+		static_cast<size_t>(yyleng));
+   }
+
+   //Where the current match starts. Sources are less than
+   // 4GiB (see SourceBuffer), so this always fits.
+   uint32_t here() const {
+	return static_cast<uint32_t>(tokenStart);
+   }
 
    int makeBareToken(int tagIn){
-        this->yylval->transToken = new Token(
-	  this->lineNum, this->colNum, tagIn);
-        colNum += static_cast<size_t>(yyleng);
+        this->yylval->transToken = new Token(here(), tagIn);
         return tagIn;
    }
 
-   void errIllegal(size_t l, size_t c, std::string match){
-	Report::fatal(l, c, "Illegal character "
-		+ match);
+   //Errors are reported at the start of the current match
+   void errAtMatch(const std::string& msg){
+	LineCol pos = source->position(tokenStart);
+	Report::fatal(pos.line, pos.col, msg);
 	hasError = true;
    }
 
-   void errStrEsc(size_t l, size_t c){
-	Report::fatal(l, c, "String literal with bad"
+   void errIllegal(std::string match){
+	errAtMatch("Illegal character " + match);
+   }
+
+   void errStrEsc(){
+	errAtMatch("String literal with bad"
 	" escape sequence ignored");
-	hasError = true;
    }
 
-   void errStrUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string"
+   void errStrUnterm(){
+	errAtMatch("Unterminated string"
 	" literal ignored");
-	hasError = true;
-	
    }
 
-   void errStrEscAndUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string literal"
+   void errStrEscAndUnterm(){
+	errAtMatch("Unterminated string literal"
 	" with bad escape sequence ignored");
-	hasError = true;
    }
 
-   void errIntOverflow(size_t l, size_t c){
-	Report::fatal(l, c, "Integer literal too large;"
+   void errIntOverflow(){
+	errAtMatch("Integer literal too large;"
 	" using max value");
-	hasError = true;
    }
 
    void warn(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
-		<< " ***WARNING*** " << msg << std::endl;
+	Report::emit(std::to_string(lineNumIn) + ":" 
+		+ std::to_string(colNumIn) + " ***WARNING*** " + msg);
    }
 
    void error(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
-		<< " ***ERROR*** " << msg << std::endl;
+	Report::emit(std::to_string(lineNumIn) + ":" 
+		+ std::to_string(colNumIn) + " ***ERROR*** " + msg);
    }
 
    static std::string tokenKindString(int tokenKind);
 
    void outputTokens(std::ostream& outstream);
 
+   //Scan the whole input into buffer, recording the
+   // position of the EOF token
+   void fill(TokenBuffer * buffer);
+
 private:
    crona::Parser::semantic_type *yylval = nullptr;
-   size_t lineNum;
-   size_t colNum;
    bool hasError;
+   const SourceBuffer * source;
+   //Byte offsets into source of the end of the input 
+   // consumed so far and of the current match (kept up to 
+   // date by YY_USER_ACTION)
+   size_t srcOffset;
+   size_t tokenStart;
 };
 
 } /* end namespace */
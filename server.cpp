@@ -0,0 +1,346 @@
+#include <chrono>
+#include <fstream>
+#include <limits.h>
+#include <sstream>
+#include <signal.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.hpp"
+#include "errors.hpp"
+#include "interner.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+#include "time_report.hpp"
+#include "trace.hpp"
+#include "worker_pool.hpp"
+
+namespace crona{
+
+static const char * REQUEST_TAG = "cronac-request-1";
+static const char * REPLY_TAG = "cronac-reply-1";
+
+//Limits on what a message may hold, so that a bad or hostile
+// peer cannot make the other side allocate without bound: a
+// command line's worth of strings, and a source (or a reply's
+// outputs) of up to MAX_BYTES in all
+static const size_t MAX_STRINGS = 1024;
+static const size_t MAX_BYTES = 256u << 20;
+
+//Identifiers stay interned between requests, for as long as
+// there are no more than this many
+static const size_t MAX_IDENTIFIERS = 1u << 20;
+
+static bool writeAll(int fd, const char * data, size_t len){
+	while (len > 0){
+		ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+		if (sent <= 0){ return false; }
+		data += sent;
+		len -= static_cast<size_t>(sent);
+	}
+	return true;
+}
+
+static bool readAll(int fd, char * data, size_t len){
+	while (len > 0){
+		ssize_t got = recv(fd, data, len, 0);
+		if (got <= 0){ return false; }
+		data += got;
+		len -= static_cast<size_t>(got);
+	}
+	return true;
+}
+
+static bool writeLength(int fd, size_t len){
+	unsigned char bytes[4];
+	bytes[0] = static_cast<unsigned char>(len >> 24);
+	bytes[1] = static_cast<unsigned char>(len >> 16);
+	bytes[2] = static_cast<unsigned char>(len >> 8);
+	bytes[3] = static_cast<unsigned char>(len);
+	return writeAll(fd, reinterpret_cast<char *>(bytes), 4);
+}
+
+static bool readLength(int fd, size_t& len){
+	unsigned char bytes[4];
+	if (!readAll(fd, reinterpret_cast<char *>(bytes), 4)){
+		return false;
+	}
+	len = (static_cast<size_t>(bytes[0]) << 24)
+		| (static_cast<size_t>(bytes[1]) << 16)
+		| (static_cast<size_t>(bytes[2]) << 8)
+		| static_cast<size_t>(bytes[3]);
+	return true;
+}
+
+static bool sendStrings(int fd, const std::vector<std::string>& strs){
+	if (!writeLength(fd, strs.size())){ return false; }
+	for (const std::string& str : strs){
+		if (!writeLength(fd, str.size())){ return false; }
+		if (!writeAll(fd, str.data(), str.size())){ return false; }
+	}
+	return true;
+}
+
+static bool recvStrings(int fd, std::vector<std::string>& strs){
+	size_t count;
+	if (!readLength(fd, count) || count > MAX_STRINGS){ return false; }
+	size_t budget = MAX_BYTES;
+	for (size_t i = 0; i < count; i++){
+		size_t len;
+		if (!readLength(fd, len) || len > budget){ return false; }
+		budget -= len;
+		std::string str(len, '\0');
+		if (len > 0 && !readAll(fd, &str[0], len)){ return false; }
+		strs.push_back(str);
+	}
+	return true;
+}
+
+//path, relative to the current directory, as an absolute path
+static std::string absolute(const char * path){
+	if (path[0] == '/'){ return path; }
+	char cwd[PATH_MAX];
+	if (getcwd(cwd, sizeof(cwd)) == nullptr){ return path; }
+	return std::string(cwd) + "/" + path;
+}
+
+//The command line as the server should run it. The server
+// has a directory (and environment) of its own, so paths it
+// reads or writes itself are made absolute here, and --cache
+// is given this side's default cache directory. Outputs come
+// back in the reply and are written relative to this side.
+static bool serverArgs(const DriverOptions& opts, int argc,
+	const char ** argv, std::vector<std::string>& args
+){
+	if (opts.emitASTCache && opts.cacheDir == nullptr){
+		std::cerr << "With --client, --emit-ast-cache needs --cache"
+			<< " or --cache-dir\n";
+		return false;
+	}
+	for (int i = 0; i < argc; i++){
+		if (strcmp(argv[i], "--cache") == 0){
+			args.push_back("--cache-dir");
+			args.push_back(absolute(opts.defaultCacheDir.c_str()));
+		} else if ((strcmp(argv[i], "--cache-dir") == 0
+			|| strcmp(argv[i], "--tokens-from") == 0) && i + 1 < argc){
+			args.push_back(argv[i]);
+			args.push_back(absolute(argv[++i]));
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+	return true;
+}
+
+//The socket serve() is listening on, for removeSocket
+static char listeningPath[sizeof(sockaddr_un::sun_path)];
+
+static void removeSocket(int sig){
+	unlink(listeningPath);
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+//Remove the socket at addr when the server is stopped by
+// SIGINT, SIGTERM or SIGHUP
+static void removeOnExit(const sockaddr_un& addr){
+	memcpy(listeningPath, addr.sun_path, sizeof(listeningPath));
+	signal(SIGINT, removeSocket);
+	signal(SIGTERM, removeSocket);
+	signal(SIGHUP, removeSocket);
+}
+
+//Read the exit code of a reply, which is 0 to 255
+static bool readExitCode(const std::string& text, int& code){
+	if (text.empty() || text.size() > 3){ return false; }
+	code = 0;
+	for (char c : text){
+		if (c < '0' || c > '9'){ return false; }
+		code = code * 10 + (c - '0');
+	}
+	return code <= 255;
+}
+
+static bool fillAddress(const char * socketPath, sockaddr_un& addr){
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(addr.sun_path)){ return false; }
+	strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+	return true;
+}
+
+void CompileServer::handle(int connection, size_t requestID){
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::string> request;
+	if (!recvStrings(connection, request) || request.size() < 3
+		|| request[0] != REQUEST_TAG){
+		Report::emit("cronac-server: request "
+			+ std::to_string(requestID) + " is malformed");
+		close(connection);
+		return;
+	}
+
+	//Rebuild an argv (with the trailing null pointer that
+	// DriverOptions::parse expects) from the request
+	std::vector<const char *> argv;
+	for (size_t i = 2; i < request.size(); i++){
+		argv.push_back(request[i].c_str());
+	}
+	int argc = static_cast<int>(argv.size());
+	argv.push_back(nullptr);
+
+	std::ostringstream out;
+	std::ostringstream err;
+	Report::redirect(&err, &out);
+	DriverOptions opts;
+	CapturedOutputs files;
+	int exitCode = 1;
+	//Whatever goes wrong, the client gets a reply and this
+	// worker thread is left as it was found for the next
+	// request
+	try {
+		if (opts.parse(argc, argv.data(), err)){
+			Interner::Use use(Interner::global());
+			CompilationSession session(opts.inFile, request[1]);
+			exitCode = Driver::run(session, opts, files);
+		}
+	} catch (InternalError * e){
+		err << "InternalError: " << e->msg() << "\n";
+		delete e;
+		exitCode = 1;
+	} catch (std::exception& e){
+		err << "InternalError: " << e.what() << "\n";
+		exitCode = 1;
+	} catch (...){
+		err << "InternalError: request failed\n";
+		exitCode = 1;
+	}
+	TimeReport::activate(nullptr);
+	Tracer::activate(nullptr);
+	Report::restore();
+
+	std::vector<std::string> reply;
+	reply.push_back(REPLY_TAG);
+	reply.push_back(std::to_string(exitCode));
+	reply.push_back(out.str());
+	reply.push_back(err.str());
+	for (auto& file : files.files()){
+		reply.push_back(file.first);
+		reply.push_back(file.second);
+	}
+	sendStrings(connection, reply);
+	close(connection);
+	Interner::global().resetIfIdle(MAX_IDENTIFIERS);
+
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<double, std::milli> elapsed = end - start;
+	std::ostringstream log;
+	log << "cronac-server: request " << requestID;
+	if (opts.inFile != nullptr){ log << " (" << opts.inFile << ")"; }
+	log << " exit " << exitCode << " in " << elapsed.count() << " ms";
+	Report::emit(log.str());
+}
+
+int CompileServer::serve(const char * socketPath){
+	sockaddr_un addr;
+	if (!fillAddress(socketPath, addr)){
+		std::cerr << "Socket path too long: " << socketPath << "\n";
+		return 1;
+	}
+
+	//A stale socket from an earlier server would make bind
+	// fail, so it is removed, but nothing else at the path is
+	struct stat info;
+	if (lstat(socketPath, &info) == 0){
+		if (!S_ISSOCK(info.st_mode)){
+			std::cerr << socketPath << " exists and is not a socket\n";
+			return 1;
+		}
+		unlink(socketPath);
+	}
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0){
+		std::cerr << "Could not create socket\n";
+		return 1;
+	}
+	sockaddr * genericAddr = reinterpret_cast<sockaddr *>(&addr);
+	if (bind(listener, genericAddr, sizeof(addr)) != 0
+		|| listen(listener, 64) != 0){
+		std::cerr << "Could not listen on " << socketPath << "\n";
+		close(listener);
+		return 1;
+	}
+	Report::emit("cronac-server: listening on " + std::string(socketPath));
+	removeOnExit(addr);
+
+	WorkerPool pool;
+	size_t requestID = 0;
+	while (true){
+		int connection = accept(listener, nullptr, nullptr);
+		if (connection < 0){ continue; }
+		size_t thisRequest = requestID++;
+		pool.submit([connection, thisRequest](){
+			handle(connection, thisRequest);
+		});
+	}
+}
+
+int CompileClient::run(const char * socketPath, const DriverOptions& opts,
+	int argc, const char ** argv
+){
+	std::vector<std::string> request;
+	request.push_back(REQUEST_TAG);
+	try {
+		SourceBuffer * source = SourceBuffer::map(opts.inFile);
+		request.push_back(std::string(source->data(), source->size()));
+		delete source;
+	} catch (InternalError * e){
+		std::cerr << "InternalError: " << e->msg() << "\n";
+		return 1;
+	}
+	if (!serverArgs(opts, argc, argv, request)){ return 1; }
+
+	sockaddr_un addr;
+	int connection = -1;
+	if (fillAddress(socketPath, addr)){
+		connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	}
+	sockaddr * genericAddr = reinterpret_cast<sockaddr *>(&addr);
+	if (connection < 0
+		|| connect(connection, genericAddr, sizeof(addr)) != 0){
+		std::cerr << "Could not connect to compile server at "
+			<< socketPath << "\n";
+		if (connection >= 0){ close(connection); }
+		return 1;
+	}
+
+	std::vector<std::string> reply;
+	bool ok = sendStrings(connection, request)
+		&& recvStrings(connection, reply);
+	close(connection);
+	int exitCode = 0;
+	if (!ok || reply.size() < 4 || reply[0] != REPLY_TAG
+	  || !readExitCode(reply[1], exitCode)){
+		std::cerr << "Bad reply from compile server\n";
+		return 1;
+	}
+
+	std::cout << reply[2];
+	std::cerr << reply[3];
+	for (size_t i = 4; i + 1 < reply.size(); i += 2){
+		std::ofstream outStream(reply[i]);
+		if (!outStream.good()){
+			std::cerr << "InternalError: Bad output file "
+				<< reply[i] << "\n";
+			return 1;
+		}
+		outStream << reply[i + 1];
+	}
+	return exitCode;
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef CRONA_SERVER_HPP
+#define CRONA_SERVER_HPP
+
+#include <string>
+#include <vector>
+#include "driver.hpp"
+
+namespace crona{
+
+//A long-lived compile server listening on a Unix domain
+// socket. Each connection carries one request: an ordinary
+// cronac command line plus the text of its input file. The
+// server runs the same Driver that main does, with every
+// output captured in memory, and replies with the exit code,
+// standard output, diagnostics and the contents of every
+// output file. Types interned by earlier requests (and the
+// allocator's free lists) stay warm between requests, as do
+// identifiers, until there are more than MAX_IDENTIFIERS
+// (see server.cpp) and the server is idle. A
+// request that is malformed or too large (see MAX_STRINGS and
+// MAX_BYTES in server.cpp) is dropped without a reply.
+//
+// Requests and replies are lists of strings, each string
+// sent as a 4-byte big-endian length followed by its bytes,
+// preceded by a 4-byte count of strings:
+//   request: "cronac-request-1", source text, argv[0..n)
+//   reply:   "cronac-reply-1", exit code, stdout, stderr,
+//            then a path and its contents for each output file
+class CompileServer{
+public:
+	//Serve requests forever. Returns only if the socket
+	// could not be set up, e.g. because something other
+	// than a stale socket is at socketPath. The socket is
+	// removed when the server is stopped by SIGINT, SIGTERM
+	// or SIGHUP.
+	static int serve(const char * socketPath);
+private:
+	static void handle(int connection, size_t requestID);
+};
+
+//The client side of CompileServer: sends a command line
+// (already checked by main) and writes back the outputs,
+// behaving as though the command had been run locally. Input
+// and cache paths are sent as absolute paths, since the
+// server does not share the client's directory.
+class CompileClient{
+public:
+	static int run(const char * socketPath, const DriverOptions& opts,
+		int argc, const char ** argv);
+};
+
+}
+
+#endif
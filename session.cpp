@@ -0,0 +1,363 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "session.hpp"
+#include "scanner.hpp"
+#include "fast_scanner.hpp"
+#include "token_file.hpp"
+#include "parallel_scan.hpp"
+#include "parallel_parse.hpp"
+#include "rd_parser.hpp"
+#include "ast_cache.hpp"
+#include "time_report.hpp"
+
+namespace crona{
+
+CompilationSession::CompilationSession(const char * inPathIn)
+: inPath(inPathIn), inMemory(false), mySource(nullptr),
+  myArena(new Arena()),
+  scanned(false), parsed(false), bodiesParsed(false), named(false),
+  typed(false), lowered(false), flattened(false), flatNamed(false),
+  myTokens(nullptr), myAST(nullptr), myNameAnalysis(nullptr),
+  myTypeAnalysis(nullptr), myIR(nullptr), cache(nullptr),
+  fastScanner(false), scanThreads(1), parseThreads(1), lazyBodies(false),
+  rdParser(false), analysisThreads(1), tokenFile(nullptr), astCacheDir(nullptr), scanReported(0),
+  astFromCache(false),
+  myFlatAST(nullptr), flatNamesOK(false){
+}
+
+CompilationSession::CompilationSession(const char * nameIn,
+	const std::string& sourceIn)
+: CompilationSession(nameIn){
+	inMemory = true;
+	source = sourceIn;
+}
+
+CompilationSession::~CompilationSession(){
+	delete myFlatAST;
+	delete myIR;
+	delete myTypeAnalysis;
+	delete myNameAnalysis;
+	delete myTokens;
+	delete myArena;
+	delete mySource;
+}
+
+const SourceBuffer * CompilationSession::sourceText(){
+	if (mySource != nullptr){ return mySource; }
+	if (inMemory){
+		mySource = SourceBuffer::copy(source);
+		source.clear();
+	} else {
+		mySource = SourceBuffer::map(inPath);
+	}
+	return mySource;
+}
+
+TokenBuffer * CompilationSession::tokens(){
+	TokenBuffer * res = scanTokens();
+	reportScan(sourceText()->size());
+	return res;
+}
+
+TokenBuffer * CompilationSession::scanTokens(){
+	if (scanned){ return myTokens; }
+	scanned = true;
+
+	const SourceBuffer * text = sourceText();
+	ArenaScope arenaScope(myArena);
+	if (tokenFile != nullptr){
+		PhaseTimer timer("read tokens");
+		std::ifstream in(tokenFile, std::ios::binary);
+		if (!in.good()){
+			std::string msg = "Bad token file ";
+			msg += tokenFile;
+			throw new InternalError(msg.c_str());
+		}
+		myTokens = TokenFile::read(in, text->size());
+		return myTokens;
+	}
+
+	PhaseTimer timer("scan");
+	//Hold the scanner's messages back, to also save them
+	// with a cached AST (see saveASTCache)
+	std::ostringstream messages;
+	std::ostream * errSink = &Report::err();
+	std::ostream * outSink = &Report::out();
+	Report::redirect(&messages, outSink);
+	try {
+		myTokens = scan(text);
+	} catch (...){
+		Report::redirect(errSink, outSink);
+		throw;
+	}
+	Report::redirect(errSink, outSink);
+	scanMessages = messages.str();
+	return myTokens;
+}
+
+//Where a message reported at "[line,col]" was, or the end of
+// the source if it has no position
+static LineCol messagePosition(const std::string& msg){
+	LineCol res;
+	res.line = SIZE_MAX;
+	res.col = SIZE_MAX;
+	size_t open = msg.find('[');
+	size_t comma = msg.find(',', open);
+	if (open == std::string::npos || comma == std::string::npos){
+		return res;
+	}
+	res.line = strtoul(msg.c_str() + open + 1, nullptr, 10);
+	res.col = strtoul(msg.c_str() + comma + 1, nullptr, 10);
+	return res;
+}
+
+void CompilationSession::reportScan(size_t offset){
+	if (scanReported >= scanMessages.size()){ return; }
+	//At the end of the source, everything is reported
+	LineCol upTo;
+	upTo.line = SIZE_MAX;
+	upTo.col = SIZE_MAX;
+	if (offset < sourceText()->size()){
+		upTo = sourceText()->position(offset);
+	}
+	while (scanReported < scanMessages.size()){
+		size_t end = scanMessages.find('\n', scanReported);
+		if (end == std::string::npos){ end = scanMessages.size(); }
+		std::string msg = scanMessages.substr(scanReported,
+			end - scanReported);
+		LineCol at = messagePosition(msg);
+		if (at.line > upTo.line
+		  || (at.line == upTo.line && at.col > upTo.col)){
+			return;
+		}
+		if (!msg.empty()){ Report::emit(msg); }
+		scanReported = end + 1;
+	}
+}
+
+TokenBuffer * CompilationSession::scan(const SourceBuffer * text){
+	if (scanThreads > 1){
+		return ParallelScan::scan(text, scanThreads, fastScanner, myArena);
+	}
+	TokenBuffer * res = new TokenBuffer();
+	if (fastScanner){
+		FastScanner scanner(text);
+		scanner.fill(res);
+	} else {
+		SourceStream inStream(text);
+		Scanner scanner(&inStream, text);
+		scanner.fill(res);
+	}
+	return res;
+}
+
+ProgramNode * CompilationSession::declarations(){
+	if (parsed){ return myAST; }
+	parsed = true;
+
+	ArenaScope arenaScope(myArena);
+	myAST = parse();
+	return myAST;
+}
+
+ProgramNode * CompilationSession::ast(){
+	if (bodiesParsed){ return myAST; }
+	bodiesParsed = true;
+
+	ProgramNode * root = declarations();
+	if (root == nullptr || !lazyBodies){ return root; }
+	ArenaScope arenaScope(myArena);
+	PhaseTimer timer("parse bodies");
+	SourceScope sourceScope(sourceText());
+	if (!parseBodies(root)){ myAST = nullptr; }
+	return myAST;
+}
+
+void CompilationSession::reportHeld(){
+	reportScan(sourceText()->size());
+}
+
+//Run a parse with what it reports held back, then report
+// the scanner's messages up to where it stopped ahead of
+// it: up to doneAt if it succeeded. Messages past a syntax
+// error are dropped.
+bool CompilationSession::holdingReports(size_t doneAt,
+	const std::function<bool(size_t&)>& run
+){
+	std::ostringstream messages;
+	std::ostringstream details;
+	std::ostream * errSink = &Report::err();
+	std::ostream * outSink = &Report::out();
+	Report::redirect(&messages, &details);
+	size_t stoppedAt = 0;
+	bool ok;
+	try {
+		ok = run(stoppedAt);
+	} catch (...){
+		Report::redirect(errSink, outSink);
+		throw;
+	}
+	Report::redirect(errSink, outSink);
+	reportScan(ok ? doneAt : stoppedAt);
+	if (!ok){ scanReported = scanMessages.size(); }
+	Report::out() << details.str();
+	Report::emitLines(messages.str());
+	return ok;
+}
+
+bool CompilationSession::parseBodies(ProgramNode * root){
+	return holdingReports(sourceText()->size(),
+		[root](size_t& stoppedAt){
+			return root->parseBodies(stoppedAt);
+		});
+}
+
+//Parse the tokens into an AST in the active arena
+ProgramNode * CompilationSession::parse(){
+	if (astCacheDir != nullptr){
+		PhaseTimer timer("load AST cache");
+		ProgramNode * cached = ASTCache::load(astCacheDir, sourceText(),
+			myArena);
+		if (cached != nullptr){
+			astFromCache = true;
+			return cached;
+		}
+	}
+
+	TokenBuffer * buffer = scanTokens();
+	PhaseTimer timer("parse");
+	SourceScope sourceScope(sourceText());
+	//The messages in deferred bodies wait for the bodies
+	size_t inputEnd = lazyBodies ? 0 : sourceText()->size();
+	if (parseThreads > 1){
+		ProgramNode * root = ParallelParse::parse(buffer, parseThreads,
+			lazyBodies, rdParser, Arena::active());
+		if (root != nullptr){
+			reportScan(inputEnd);
+			return root;
+		}
+		//Otherwise parse again in one piece, to report the
+		// syntax error as usual
+	} else if (rdParser){
+		RDParser rd(buffer, 0, buffer->size(), lazyBodies);
+		ProgramNode * root = rd.parse();
+		if (root != nullptr){
+			if (lazyBodies){ root->deferBodies(buffer, rd.skipped()); }
+			reportScan(inputEnd);
+			return root;
+		}
+		//Otherwise let the bison Parser report the error
+	}
+
+	//This pointer will be set to the root of the
+	// AST after parsing
+	ProgramNode * root = nullptr;
+	TokenSlice slice(buffer, 0, buffer->size(), lazyBodies);
+	Parser parser(slice, &root);
+	//A syntax error is reported after the scanner's messages
+	// up to the token the parser stopped at
+	bool ok = holdingReports(inputEnd, [&](size_t& stoppedAt){
+		if (parser.parse() == 0){ return true; }
+		stoppedAt = slice.lastOffset();
+		return false;
+	});
+	if (!ok){ return nullptr; }
+	if (lazyBodies){ root->deferBodies(buffer, slice.skipped()); }
+	return root;
+}
+
+FlatAST * CompilationSession::flatAST(){
+	if (flattened){ return myFlatAST; }
+	flattened = true;
+
+	Arena treeArena;
+	ArenaScope arenaScope(&treeArena);
+	ProgramNode * root = parse();
+	if (root == nullptr){ return nullptr; }
+	if (lazyBodies){
+		PhaseTimer timer("parse bodies");
+		SourceScope sourceScope(sourceText());
+		if (!parseBodies(root)){ return nullptr; }
+	}
+	PhaseTimer timer("flatten");
+	myFlatAST = FlatAST::build(root);
+	return myFlatAST;
+}
+
+FlatAST * CompilationSession::namedFlatAST(){
+	if (flatNamed){ return flatNamesOK ? myFlatAST : nullptr; }
+	flatNamed = true;
+
+	FlatAST * flat = flatAST();
+	if (flat == nullptr){ return nullptr; }
+	PhaseTimer timer("name analysis");
+	SourceScope sourceScope(sourceText());
+	flatNamesOK = flat->nameAnalysis();
+	return flatNamesOK ? flat : nullptr;
+}
+
+void CompilationSession::saveASTCache(const std::string& dir){
+	if (flattened){
+		if (myFlatAST == nullptr || astFromCache){ return; }
+		PhaseTimer timer("save AST cache");
+		ASTCache::save(dir, sourceText(), myFlatAST, scanMessages);
+		return;
+	}
+	ProgramNode * root = ast();
+	if (root == nullptr || astFromCache){ return; }
+	PhaseTimer timer("save AST cache");
+	FlatAST * flat = FlatAST::build(root);
+	ASTCache::save(dir, sourceText(), flat, scanMessages);
+	delete flat;
+}
+
+NameAnalysis * CompilationSession::nameAnalysis(){
+	if (named){ return myNameAnalysis; }
+	named = true;
+
+	ProgramNode * root = ast();
+	if (root == nullptr){ return nullptr; }
+	PhaseTimer timer("name analysis");
+	SourceScope sourceScope(sourceText());
+	myNameAnalysis = NameAnalysis::build(root, analysisThreads);
+	return myNameAnalysis;
+}
+
+TypeAnalysis * CompilationSession::typeAnalysis(){
+	if (typed){ return myTypeAnalysis; }
+	typed = true;
+
+	NameAnalysis * names = nameAnalysis();
+	if (names == nullptr){ return nullptr; }
+	if (cache != nullptr){
+		PhaseTimer timer("cache lookup");
+		cache->attach(names->ast);
+	}
+	PhaseTimer timer("type analysis");
+	//Type analysis adds nodes (ByteToIntNode) to the AST
+	ArenaScope arenaScope(myArena);
+	SourceScope sourceScope(sourceText());
+	myTypeAnalysis = TypeAnalysis::build(names, analysisThreads);
+	return myTypeAnalysis;
+}
+
+IRProgram * CompilationSession::ir(){
+	if (lowered){ return myIR; }
+	lowered = true;
+
+	TypeAnalysis * types = typeAnalysis();
+	if (types == nullptr){ return nullptr; }
+	{
+		PhaseTimer timer("3AC lowering");
+		myIR = types->ast->to3AC(types);
+	}
+	if (cache != nullptr){
+		PhaseTimer timer("cache store");
+		cache->store(myIR);
+	}
+	return myIR;
+}
+
+}
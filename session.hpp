@@ -0,0 +1,153 @@
+#ifndef CRONA_SESSION_HPP
+#define CRONA_SESSION_HPP
+
+#include <functional>
+#include "ast.hpp"
+#include "flat_ast.hpp"
+#include "token_stream.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+#include "proc_cache.hpp"
+#include "source_buffer.hpp"
+#include "arena.hpp"
+
+namespace crona{
+
+//A single compilation of a single input file. Each phase
+// of the pipeline (scanning, parsing, name analysis, type
+// analysis, 3AC lowering) is run at most once, the first
+// time its result is asked for, and the result is kept so
+// that every requested output can be fed from it. A phase
+// that fails is not retried: its getter keeps returning
+// nullptr. Everything the session built (tokens, AST, 
+// analyses, 3AC) is freed with the session.
+class CompilationSession{
+public:
+	CompilationSession(const char * inPathIn);
+	//Compile source text that is already in memory. The
+	// name is only used in messages.
+	CompilationSession(const char * nameIn, const std::string& sourceIn);
+	~CompilationSession();
+	//The input text, which stays in memory (mapped, for a
+	// file) until the session is done
+	const SourceBuffer * sourceText();
+	//The tokens, with everything the scanner had to say
+	// about them reported
+	TokenBuffer * tokens();
+	//The whole AST, bodies and all
+	ProgramNode * ast();
+	//The AST as parsed before any function body has been
+	// asked for: with lazy bodies, just the declarations
+	// and the functions' signatures, which is all a query
+	// for them needs. Otherwise, the same as ast().
+	ProgramNode * declarations();
+	//Report the scanner's messages that are still held back:
+	// with lazy bodies, those in bodies that were never
+	// parsed. Call once nothing more is wanted.
+	void reportHeld();
+	NameAnalysis * nameAnalysis();
+	TypeAnalysis * typeAnalysis();
+	//The AST as a FlatAST. The tree it is made from is
+	// parsed into an arena of its own, which is freed as
+	// soon as the tree has been flattened, so this does not
+	// also build ast().
+	FlatAST * flatAST();
+	//flatAST(), after name analysis over it, or nullptr if
+	// that failed
+	FlatAST * namedFlatAST();
+	IRProgram * ir();
+	//Reuse (and fill) a cache of per-function 3AC. Must be
+	// set before type analysis runs.
+	void setCache(ProcCache * cacheIn){ cache = cacheIn; }
+	//Scan with a FastScanner rather than the flex Scanner.
+	// Must be set before scanning.
+	void setFastScanner(bool fastIn){ fastScanner = fastIn; }
+	//Scan large inputs in pieces on up to threads threads
+	// (see ParallelScan). Must be set before scanning.
+	void setScanThreads(size_t threads){ scanThreads = threads; }
+	//Parse large inputs in pieces on up to threads threads
+	// (see ParallelParse). Must be set before parsing.
+	void setParseThreads(size_t threads){ parseThreads = threads; }
+	//Skip over function bodies when parsing, and parse each
+	// only when it is first needed. Must be set before
+	// parsing.
+	void setLazyBodies(bool lazyIn){ lazyBodies = lazyIn; }
+	//Parse with an RDParser rather than the bison Parser
+	// (which still reports any syntax error). Must be set
+	// before parsing.
+	void setRDParser(bool rdIn){ rdParser = rdIn; }
+	//Analyze function bodies' names and types on up to
+	// threads threads (see ParallelAnalysis). Must be set
+	// before name analysis.
+	void setAnalysisThreads(size_t threads){ analysisThreads = threads; }
+	//Read the tokens from a TokenFile at path (if not
+	// nullptr) rather than scanning. Must be set before
+	// scanning.
+	void setTokenFile(const char * path){ tokenFile = path; }
+	//Look for the AST in an ASTCache in dir before scanning
+	// and parsing. Must be set before parsing.
+	void setASTCacheDir(const char * dir){ astCacheDir = dir; }
+	//Save the AST to an ASTCache in dir, unless it was
+	// loaded from one. Uses flatAST() if it has been built
+	// and ast() otherwise.
+	void saveASTCache(const std::string& dir);
+	//Bytes allocated from the session's arena so far
+	size_t arenaBytes() const { return myArena->used(); }
+private:
+	//The tokens, with the scanner's messages held back in
+	// scanMessages
+	TokenBuffer * scanTokens();
+	TokenBuffer * scan(const SourceBuffer * text);
+	//Report the held-back scanner messages that are at or
+	// before offset in the source and were not yet reported
+	void reportScan(size_t offset);
+	bool holdingReports(size_t doneAt,
+		const std::function<bool(size_t&)>& run);
+	ProgramNode * parse();
+	bool parseBodies(ProgramNode * root);
+
+	const char * inPath;
+	bool inMemory;
+	std::string source;
+
+	SourceBuffer * mySource;
+	//Holds the tokens and the AST
+	Arena * myArena;
+	bool scanned;
+	bool parsed;
+	bool bodiesParsed;
+	bool named;
+	bool typed;
+	bool lowered;
+	bool flattened;
+	bool flatNamed;
+
+	TokenBuffer * myTokens;
+	ProgramNode * myAST;
+	NameAnalysis * myNameAnalysis;
+	TypeAnalysis * myTypeAnalysis;
+	IRProgram * myIR;
+	ProcCache * cache;
+	bool fastScanner;
+	size_t scanThreads;
+	size_t parseThreads;
+	bool lazyBodies;
+	bool rdParser;
+	size_t analysisThreads;
+	const char * tokenFile;
+	const char * astCacheDir;
+	//What the scanner reported, and how much of it has been
+	// passed on. The messages are passed on as the parser
+	// reaches the tokens they come before, as they were when
+	// the parser pulled tokens from the scanner one by one,
+	// so none past a syntax error are reported.
+	std::string scanMessages;
+	size_t scanReported;
+	bool astFromCache;
+	FlatAST * myFlatAST;
+	bool flatNamesOK;
+};
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source_buffer.hpp"
+#include "errors.hpp"
+
+namespace crona{
+
+SourceBuffer * SourceBuffer::map(const char * path){
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+		if (fd >= 0){ close(fd); }
+		std::string msg = "Bad input stream ";
+		msg += path;
+		throw new InternalError(msg.c_str());
+	}
+
+	try {
+		checkSize(static_cast<size_t>(info.st_size));
+	} catch (InternalError *){
+		close(fd);
+		throw;
+	}
+
+	SourceBuffer * res = new SourceBuffer();
+	res->mySize = static_cast<size_t>(info.st_size);
+	//mmap refuses empty mappings, and an empty file has
+	// nothing to map anyway
+	if (res->mySize > 0){
+		void * addr = mmap(nullptr, res->mySize, PROT_READ,
+			MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED){
+			close(fd);
+			delete res;
+			std::string msg = "Bad input stream ";
+			msg += path;
+			throw new InternalError(msg.c_str());
+		}
+		//The scanner reads front to back exactly once
+		madvise(addr, res->mySize, MADV_SEQUENTIAL);
+		res->myData = static_cast<const char *>(addr);
+		res->mapped = true;
+	}
+	close(fd);
+	return res;
+}
+
+SourceBuffer * SourceBuffer::copy(const std::string& text){
+	checkSize(text.size());
+	SourceBuffer * res = new SourceBuffer();
+	res->owned = text;
+	res->myData = res->owned.data();
+	res->mySize = res->owned.size();
+	return res;
+}
+
+SourceBuffer::~SourceBuffer(){
+	if (mapped){
+		munmap(const_cast<char *>(myData), mySize);
+	}
+}
+
+void SourceBuffer::checkSize(size_t size){
+	if (size >= UINT32_MAX){
+		throw new InternalError("Input too large (4GiB or more)");
+	}
+}
+
+void SourceBuffer::buildLineStarts() const {
+	lineStarts.push_back(0);
+	const char * pos = myData;
+	const char * end = myData + mySize;
+	while (pos < end){
+		const void * found = memchr(pos, '\n', static_cast<size_t>(end - pos));
+		if (found == nullptr){ break; }
+		pos = static_cast<const char *>(found) + 1;
+		lineStarts.push_back(static_cast<uint32_t>(pos - myData));
+	}
+}
+
+LineCol SourceBuffer::position(size_t offset) const {
+	std::call_once(linesBuilt, [this](){ buildLineStarts(); });
+	auto after = std::upper_bound(lineStarts.begin(), lineStarts.end(),
+		offset);
+	size_t lineIdx = static_cast<size_t>(after - lineStarts.begin()) - 1;
+	LineCol res;
+	res.line = lineIdx + 1;
+	res.col = offset - lineStarts[lineIdx] + 1;
+	return res;
+}
+
+LineCol SourceBuffer::locate(size_t offset){
+	const SourceBuffer * source = active();
+	if (source == nullptr){
+		throw new InternalError("No source to find a position in");
+	}
+	return source->position(offset);
+}
+
+SourceStream::Buf::Buf(const SourceBuffer * source, size_t from, size_t to){
+	//The get area is only ever read from, so it can
+	// point at the (read-only) mapping itself
+	char * begin = const_cast<char *>(source->data());
+	setg(begin + from, begin + from, begin + to);
+}
+
+SourceStream::SourceStream(const SourceBuffer * source)
+: SourceStream(source, 0, source->size()){
+}
+
+SourceStream::SourceStream(const SourceBuffer * source, size_t from,
+	size_t to
+)
+: std::istream(nullptr), buf(source, from, to){
+	rdbuf(&buf);
+}
+
+}
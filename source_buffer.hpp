@@ -0,0 +1,102 @@
+#ifndef CRONA_SOURCE_BUFFER_HPP
+#define CRONA_SOURCE_BUFFER_HPP
+
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace crona{
+
+class LineCol{
+public:
+	size_t line;
+	size_t col;
+};
+
+//The text of one input, held in memory for the whole of a
+// compilation. A file is mapped rather than read, so it is
+// never copied into the compiler's heap; source text that
+// is already in memory (e.g. sent to the compile server)
+// is kept as a string.
+//
+// Tokens and AST nodes only record the byte offset they
+// start at (inputs are limited to 4GiB so that it fits in
+// 32 bits). Their line and column are worked out from the
+// offset when a message needs them, against the buffer that
+// is active on the current thread (see SourceScope).
+class SourceBuffer{
+public:
+	//Map the file at path. Throws an InternalError if it
+	// can't be opened or is too large.
+	static SourceBuffer * map(const char * path);
+	static SourceBuffer * copy(const std::string& text);
+	~SourceBuffer();
+
+	const char * data() const { return myData; }
+	size_t size() const { return mySize; }
+
+	//Line and column (from 1) of a byte offset, counted the
+	// way the scanner counts them: a tab is one column and
+	// "\r\n" is one line break. The table of line starts is
+	// built the first time a position is asked for.
+	LineCol position(size_t offset) const;
+
+	static const SourceBuffer * active(){ return current(); }
+	static void activate(const SourceBuffer * source){ current() = source; }
+	//position() in the active buffer
+	static LineCol locate(size_t offset);
+private:
+	SourceBuffer() : myData(nullptr), mySize(0), mapped(false){ }
+	SourceBuffer(const SourceBuffer&) = delete;
+	SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+	static void checkSize(size_t size);
+	void buildLineStarts() const;
+
+	static const SourceBuffer *& current(){
+		thread_local const SourceBuffer * source = nullptr;
+		return source;
+	}
+
+	const char * myData;
+	size_t mySize;
+	bool mapped;
+	std::string owned;
+	mutable std::once_flag linesBuilt;
+	mutable std::vector<uint32_t> lineStarts;
+};
+
+//Makes a SourceBuffer the active one for as long as it is
+// in scope
+class SourceScope{
+public:
+	SourceScope(const SourceBuffer * source)
+	: saved(SourceBuffer::active()){
+		SourceBuffer::activate(source);
+	}
+	~SourceScope(){ SourceBuffer::activate(saved); }
+private:
+	const SourceBuffer * saved;
+};
+
+//An istream that reads straight out of a SourceBuffer, for
+// the flex scanner (which takes its input from an istream)
+class SourceStream : public std::istream{
+public:
+	SourceStream(const SourceBuffer * source);
+	//Only the bytes of source from offset from up to to
+	SourceStream(const SourceBuffer * source, size_t from, size_t to);
+private:
+	class Buf : public std::streambuf{
+	public:
+		Buf(const SourceBuffer * source, size_t from, size_t to);
+	};
+	Buf buf;
+};
+
+}
+
+#endif
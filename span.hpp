@@ -0,0 +1,68 @@
+#ifndef CRONA_SPAN_HPP
+#define CRONA_SPAN_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "arena.hpp"
+
+namespace crona{
+
+//A pointer and a length: a run of Ts laid out contiguously,
+// which the span does not own. AST nodes keep their
+// children this way, in the compilation's arena, so walking
+// them is a linear scan rather than chasing list links.
+template <typename T>
+class Span{
+public:
+	Span() : items(nullptr), count(0){ }
+	Span(T * itemsIn, size_t countIn) : items(itemsIn), count(countIn){ }
+
+	T * begin() const { return items; }
+	T * end() const { return items + count; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T& operator[](size_t idx) const { return items[idx]; }
+	T& front() const { return items[0]; }
+	T& back() const { return items[count - 1]; }
+private:
+	T * items;
+	size_t count;
+};
+
+//Accumulates a Span in the active arena, for parser actions
+// that see a list one element at a time. Growing doubles
+// the capacity and abandons the old storage to the arena,
+// so at most half the space a list ends up in is wasted,
+// and finishing is free.
+template <typename T>
+class SpanBuilder{
+	static_assert(std::is_trivially_copyable<T>::value,
+		"span elements are copied bytewise");
+public:
+	SpanBuilder() : items(nullptr), count(0), capacity(0){ }
+
+	void push_back(T item){
+		if (count == capacity){ grow(); }
+		items[count++] = item;
+	}
+	size_t size() const { return count; }
+	Span<T> finish() const { return Span<T>(items, count); }
+private:
+	void grow(){
+		size_t newCapacity = capacity == 0 ? 4 : capacity * 2;
+		T * newItems = static_cast<T *>(
+			Arena::allocateCurrent(newCapacity * sizeof(T)));
+		if (count > 0){ memcpy(newItems, items, count * sizeof(T)); }
+		items = newItems;
+		capacity = newCapacity;
+	}
+
+	T * items;
+	size_t count;
+	size_t capacity;
+};
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CRONA_STR_REF_HPP
+#define CRONA_STR_REF_HPP
+
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace crona{
+
+//A non-owning view of some characters, like C++17's
+// std::string_view. Identifier and string literal tokens
+// (and the AST nodes and symbols made from them) refer to
+// their text in the compilation's SourceBuffer this way, so
+// the text is never copied after scanning. A StrRef is only
+// valid while whatever it points into is alive.
+class StrRef{
+public:
+	StrRef() : ptr(""), len(0){ }
+	StrRef(const char * ptrIn, size_t lenIn) : ptr(ptrIn), len(lenIn){ }
+	//Views of strings are handy for lookups, but must not
+	// outlive the string
+	StrRef(const std::string& str) : ptr(str.data()), len(str.size()){ }
+	StrRef(const char * cstr) : ptr(cstr), len(strlen(cstr)){ }
+
+	const char * data() const { return ptr; }
+	size_t size() const { return len; }
+	bool empty() const { return len == 0; }
+	char operator[](size_t idx) const { return ptr[idx]; }
+	std::string str() const { return std::string(ptr, len); }
+
+	bool operator==(const StrRef& other) const {
+		return len == other.len
+			&& (ptr == other.ptr || memcmp(ptr, other.ptr, len) == 0);
+	}
+	bool operator!=(const StrRef& other) const {
+		return !(*this == other);
+	}
+	bool operator<(const StrRef& other) const {
+		size_t common = len < other.len ? len : other.len;
+		int cmp = memcmp(ptr, other.ptr, common);
+		if (cmp != 0){ return cmp < 0; }
+		return len < other.len;
+	}
+private:
+	const char * ptr;
+	size_t len;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const StrRef& ref){
+	return out.write(ref.data(), static_cast<std::streamsize>(ref.size()));
+}
+
+inline std::string operator+(const std::string& lhs, const StrRef& rhs){
+	std::string res = lhs;
+	res.append(rhs.data(), rhs.size());
+	return res;
+}
+
+inline std::string operator+(const StrRef& lhs, const std::string& rhs){
+	std::string res = lhs.str();
+	res += rhs;
+	return res;
+}
+
+inline std::string operator+(const char * lhs, const StrRef& rhs){
+	return std::string(lhs) + rhs;
+}
+
+}
+
+namespace std{
+
+//FNV-1a over the characters
+template <>
+struct hash<crona::StrRef>{
+	size_t operator()(const crona::StrRef& ref) const {
+		size_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < ref.size(); i++){
+			hash ^= static_cast<unsigned char>(ref[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+};
+
+}
+
+#endif
@@ -2,89 +2,192 @@
 #include "types.hpp"
 namespace crona{
 
-SymbolTable::SymbolTable(){
-	scopeTableChain = new std::list<ScopeTable *>();
+const uint32_t SymbolTable::NO_BINDING;
+
+SymbolTable::SymbolTable()
+: outer(nullptr), outerAsOf(0), baseDepth(0), globalSlots(0), fnSlots(0){
+}
+
+SymbolTable::SymbolTable(const SymbolTable * outerIn, size_t asOf)
+: outer(outerIn), outerAsOf(asOf),
+  baseDepth(static_cast<uint32_t>(outerIn->baseDepth
+  	+ outerIn->scopeStarts.size())),
+  globalSlots(0), fnSlots(0){
+}
+
+SymbolTable::~SymbolTable(){
+	for (ScopeTable * scope : scopes){
+		delete scope;
+	}
 }
 
 void SymbolTable::print(){
-	for(auto scope : *scopeTableChain){
+	for (size_t depth = scopeStarts.size(); depth > 0; depth--){
 		std::cout << "--- scope ---\n";
-		std::cout << scope->toString();
+		std::cout << scopes[depth - 1]->toString();
+	}
+}
+
+size_t SymbolTable::snapshot() const{
+	//Until something is unbound, bindings are only ever
+	// appended, so a binding was made before the snapshot iff
+	// its index is below it
+	if (!freeBindings.empty()){
+		throw new InternalError("Snapshot of a symbol table"
+			" that has left a scope");
 	}
+	return bindings.size();
 }
 
 ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
-	scopeTableChain->push_front(newScope);
-	return newScope;
+	size_t open = scopeStarts.size();
+	uint32_t depth = static_cast<uint32_t>(baseDepth + open);
+	scopeStarts.push_back(undoLog.size());
+	//Scopes at depth 1 are functions' outermost
+	if (depth == 1){ fnSlots = 0; }
+	if (scopes.size() == open){
+		scopes.push_back(new ScopeTable(this, depth));
+	}
+	return scopes[open];
 }
 
 void SymbolTable::leaveScope(){
-	if (scopeTableChain->empty()){
+	if (scopeStarts.empty()){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
-	scopeTableChain->pop_front();
+	uint32_t depth = static_cast<uint32_t>(baseDepth
+		+ scopeStarts.size() - 1);
+	size_t kept = scopeStarts.back();
+	scopeStarts.pop_back();
+	for (size_t i = kept; i < undoLog.size(); i++){
+		Undo undo = undoLog[i];
+		//A name bound in an enclosing scope while this one
+		// was open (as a function's name is) stays bound
+		if (undo.depth != depth){
+			undoLog[kept++] = undo;
+			continue;
+		}
+		//Anything bound deeper is gone, so this scope's
+		// binding of the name is the innermost one
+		uint32_t& head = innermost.find(undo.nameID)->second;
+		uint32_t popped = head;
+		head = bindings[popped].shadowed;
+		freeBindings.push_back(popped);
+	}
+	undoLog.resize(kept);
 }
 
 ScopeTable * SymbolTable::getCurrentScope(){
-	return scopeTableChain->front();
+	return scopes[scopeStarts.size() - 1];
+}
+
+bool SymbolTable::clash(uint32_t nameID){
+	return getCurrentScope()->clash(nameID);
 }
 
-bool SymbolTable::clash(std::string varName){
-	bool hasClash = getCurrentScope()->clash(varName);
-	return hasClash;
+SemSymbol * SymbolTable::find(uint32_t nameID){
+	auto found = innermost.find(nameID);
+	if (found == innermost.end() || found->second == NO_BINDING){
+		if (outer != nullptr){ return outer->findAsOf(nameID, outerAsOf); }
+		return nullptr;
+	}
+	return bindings[found->second].symbol;
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
+SemSymbol * SymbolTable::findAsOf(uint32_t nameID, size_t asOf) const{
+	auto found = innermost.find(nameID);
+	if (found == innermost.end()){ return nullptr; }
+	uint32_t at = found->second;
+	while (at != NO_BINDING && at >= asOf){
+		at = bindings[at].shadowed;
 	}
-	return nullptr;
+	if (at == NO_BINDING){ return nullptr; }
+	return bindings[at].symbol;
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
-	return scopeTableChain->front()->insert(symbol);
+	return getCurrentScope()->insert(symbol);
+}
+
+SemSymbol * SymbolTable::lookupAt(uint32_t nameID, uint32_t depth){
+	auto found = innermost.find(nameID);
+	if (found == innermost.end()){ return nullptr; }
+	uint32_t at = found->second;
+	while (at != NO_BINDING && bindings[at].depth > depth){
+		at = bindings[at].shadowed;
+	}
+	if (at == NO_BINDING || bindings[at].depth != depth){
+		return nullptr;
+	}
+	return bindings[at].symbol;
+}
+
+bool SymbolTable::insertAt(SemSymbol * symbol, uint32_t depth){
+	uint32_t nameID = symbol->getNameID();
+	auto slot = innermost.emplace(nameID, NO_BINDING).first;
+	//Bindings below the innermost only come from binding a
+	// name in an enclosing scope, which is rare
+	uint32_t above = NO_BINDING;
+	uint32_t at = slot->second;
+	while (at != NO_BINDING && bindings[at].depth > depth){
+		above = at;
+		at = bindings[at].shadowed;
+	}
+	if (at != NO_BINDING && bindings[at].depth == depth){
+		return false;
+	}
+	uint32_t added = newBinding(symbol, depth, at);
+	if (above == NO_BINDING){
+		slot->second = added;
+	} else {
+		bindings[above].shadowed = added;
+	}
+	undoLog.push_back(Undo{nameID, depth});
+	if (symbol->getKind() == VAR){
+		symbol->setSlot(depth, depth == 0 ? globalSlots++ : fnSlots++);
+	}
+	return true;
 }
 
-ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+uint32_t SymbolTable::newBinding(SemSymbol * symbol, uint32_t depth,
+	uint32_t shadowed
+){
+	Binding binding{symbol, depth, shadowed};
+	if (freeBindings.empty()){
+		bindings.push_back(binding);
+		return static_cast<uint32_t>(bindings.size() - 1);
+	}
+	uint32_t idx = freeBindings.back();
+	freeBindings.pop_back();
+	bindings[idx] = binding;
+	return idx;
 }
 
 std::string ScopeTable::toString(){
 	std::string result = "";
-	for (auto entry : *symbols){
-		result += entry.second->toString();
+	for (auto undo : table->undoLog){
+		if (undo.depth != depth){ continue; }
+		result += lookup(undo.nameID)->toString();
 		result += "\n";
 	}
 	return result;
 }
 
-bool ScopeTable::clash(std::string varName){
-	SemSymbol * found = lookup(varName);
+bool ScopeTable::clash(uint32_t nameID){
+	SemSymbol * found = lookup(nameID);
 	if (found != nullptr){
 		return true;
 	}
 	return false;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
-	auto found = symbols->find(name);
-	if (found == symbols->end()){
-		return NULL;
-	}
-	return found->second;
+SemSymbol * ScopeTable::lookup(uint32_t nameID){
+	return table->lookupAt(nameID, depth);
 }
 
 bool ScopeTable::insert(SemSymbol * symbol){
-	std::string symName = symbol->getName();
-	bool alreadyInScope = (this->lookup(symName) != NULL);
-	if (alreadyInScope){
-		return false;
-	}
-	this->symbols->insert(std::make_pair(symName, symbol));
-	return true;
+	return table->insertAt(symbol, depth);
 }
 
 std::string SemSymbol::toString(){
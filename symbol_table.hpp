@@ -1,9 +1,12 @@
 #ifndef CRONA_SYMBOL_TABLE_HPP
 #define CRONA_SYMBOL_TABLE_HPP
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <vector>
 #include "types.hpp"
+#include "str_ref.hpp"
 
 //Use an alias template so that we can use
 // "HashMap" and it means "std::unordered_map"
@@ -26,11 +29,24 @@ enum SymbolKind {
 // symbol table. 
 class SemSymbol {
 public:
-	SemSymbol(std::string nameIn, DataType * typeIn) 
-	: myName(nameIn), myType(typeIn){ }
+	SemSymbol(StrRef nameIn, uint32_t nameIDIn, DataType * typeIn) 
+	: myName(nameIn), myNameID(nameIDIn), myType(typeIn),
+	  myDepth(0), mySlot(0){ }
 	virtual std::string toString();
-	std::string getName() const { return myName; }
+	StrRef getName() const { return myName; }
+	//The name's key in the Interner
+	uint32_t getNameID() const { return myNameID; }
 	virtual SymbolKind getKind() const = 0;
+	//Where a variable is bound: the depth of its scope (0
+	// for the globals) and its slot, which numbers the
+	// variables of the globals scope, or of one function
+	// (formals first, then locals), densely from 0
+	uint32_t getDepth() const { return myDepth; }
+	uint32_t getSlot() const { return mySlot; }
+	void setSlot(uint32_t depthIn, uint32_t slotIn){
+		myDepth = depthIn;
+		mySlot = slotIn;
+	}
 
 	virtual DataType * getDataType() const{
 		return myType;
@@ -43,66 +59,146 @@ public:
 		return "UNKNOWN KIND";
 	} 
 private:
-	std::string myName;
+	StrRef myName;
+	uint32_t myNameID;
 	DataType * myType;
+	uint32_t myDepth;
+	uint32_t mySlot;
 };
 
 class VarSymbol : public SemSymbol {
 public:
-	VarSymbol(std::string name, DataType * type) 
-	: SemSymbol(name, type) { }
+	VarSymbol(StrRef name, uint32_t nameID, DataType * type) 
+	: SemSymbol(name, nameID, type) { }
 	virtual SymbolKind getKind() const override { return VAR; } 
 };
 
 class FnSymbol : public SemSymbol{
 public:
-	FnSymbol(std::string name, FnType * fnType)
-	: SemSymbol(name, fnType){ }
+	FnSymbol(StrRef name, uint32_t nameID, FnType * fnType)
+	: SemSymbol(name, nameID, fnType){ }
 	virtual SymbolKind getKind() const { return FN; }
 	SymbolKind getKind(){ return FN; } 
 };
 
-//A single scope. The symbol table is broken down into a 
-// chain of scope tables, and each scope table holds 
-// semantic symbols for a single scope. For example,
-// the globals scope will be represented by a ScopeTable,
-// and the contents of each function can be represented by
-// a ScopeTable.
+class SymbolTable;
+
+//A single scope of a SymbolTable, as a handle on the table:
+// the scope's symbols are kept in the table itself. The
+// globals scope is one ScopeTable, and the contents of each
+// function another. A handle is good until its scope is
+// left.
 class ScopeTable {
 	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
+		ScopeTable(SymbolTable * tableIn, uint32_t depthIn)
+		: table(tableIn), depth(depthIn){ }
+		//Symbols are found by the Interner ID of their name
+		SemSymbol * lookup(uint32_t nameID);
 		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
+		bool clash(uint32_t nameID);
 		std::string toString();
-		void addVar(std::string name, DataType * type){
-			insert(new VarSymbol(name, type));
+		void addVar(StrRef name, uint32_t nameID, DataType * type){
+			insert(new VarSymbol(name, nameID, type));
 		}
-		void addFn(std::string name, FnType * type){
-			insert(new FnSymbol(name, type));
+		void addFn(StrRef name, uint32_t nameID, FnType * type){
+			insert(new FnSymbol(name, nameID, type));
 		}
 	private:
-		HashMap<std::string, SemSymbol *> * symbols;
+		SymbolTable * table;
+		uint32_t depth;
 };
 
+//The scopes in force at one point of a program. Rather than
+// a hash table per scope, searched innermost first, there is
+// one hash table from each name to a stack of its bindings,
+// innermost on top, so finding a name is a single probe
+// however deep the nesting. Each scope keeps an undo log of
+// the names it bound, and leaving it pops just those
+// bindings. Entering and leaving a scope allocate nothing
+// once the table has warmed up. Each variable is given its
+// slot (see SemSymbol::getSlot) as it is bound.
+//
+// A table can also be opened on top of another, as it was at
+// some earlier point, to analyze one function's body while
+// other threads analyze other bodies on top of the same
+// table (see ParallelAnalysis).
 class SymbolTable{
 	public:
 		SymbolTable();
+		//A table whose outermost scopes are those of outer as
+		// of the given snapshot. Scopes entered in it nest
+		// inside the scopes open in outer, and names it
+		// doesn't bind itself are found in outer. Only reads
+		// outer, which must not change while this is in use.
+		SymbolTable(const SymbolTable * outerIn, size_t asOf);
+		~SymbolTable();
+		//The point this table has reached, to open tables on
+		// top of it as of now. Only meaningful while nothing
+		// has been unbound (no scope has been left).
+		size_t snapshot() const;
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
-		void addVar(std::string name, DataType * type){
-			getCurrentScope()->addVar(name, type);
+		SemSymbol * find(uint32_t nameID);
+		bool clash(uint32_t nameID);
+		void addVar(StrRef name, uint32_t nameID, DataType * type){
+			getCurrentScope()->addVar(name, nameID, type);
 		}
-		void addFn(std::string name, FnType * type){
-			getCurrentScope()->addFn(name, type);
+		void addFn(StrRef name, uint32_t nameID, FnType * type){
+			getCurrentScope()->addFn(name, nameID, type);
 		}
 		void print();
 	private:
-		std::list<ScopeTable *> * scopeTableChain;
+		friend class ScopeTable;
+		static const uint32_t NO_BINDING = UINT32_MAX;
+
+		//symbol, bound in the scope at depth, hiding the
+		// binding at index shadowed (if any)
+		class Binding{
+		public:
+			SemSymbol * symbol;
+			uint32_t depth;
+			uint32_t shadowed;
+		};
+		//nameID was bound in the scope at depth
+		class Undo{
+		public:
+			uint32_t nameID;
+			uint32_t depth;
+		};
+
+		//The binding of nameID in the scope at depth, if
+		// there is one
+		SemSymbol * lookupAt(uint32_t nameID, uint32_t depth);
+		//The innermost binding of nameID made before snapshot
+		// asOf
+		SemSymbol * findAsOf(uint32_t nameID, size_t asOf) const;
+		bool insertAt(SemSymbol * symbol, uint32_t depth);
+		uint32_t newBinding(SemSymbol * symbol, uint32_t depth,
+			uint32_t shadowed);
+
+		//The innermost binding of each name ever bound
+		HashMap<uint32_t, uint32_t> innermost;
+		//Bindings are recycled through freeBindings
+		std::vector<Binding> bindings;
+		std::vector<uint32_t> freeBindings;
+		std::vector<Undo> undoLog;
+		//Where each open scope's part of undoLog starts
+		std::vector<size_t> scopeStarts;
+		//The handle of each open scope, reused by later scopes
+		// at the same depth
+		std::vector<ScopeTable *> scopes;
+		//The table this one is opened on top of, if any, and
+		// how much of it this one sees
+		const SymbolTable * outer;
+		size_t outerAsOf;
+		//The depth of this table's outermost scope
+		uint32_t baseDepth;
+		//The next free slots among the globals and among the
+		// variables of the function being analyzed
+		uint32_t globalSlots;
+		uint32_t fnSlots;
 };
 
 	
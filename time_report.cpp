@@ -0,0 +1,192 @@
+#include <iomanip>
+#include <sys/resource.h>
+#include "time_report.hpp"
+
+namespace crona{
+
+static double toMillis(const timeval& tv){
+	return static_cast<double>(tv.tv_sec) * 1000.0
+		+ static_cast<double>(tv.tv_usec) / 1000.0;
+}
+
+Times Times::now(){
+	Times res;
+	std::chrono::duration<double, std::milli> wall =
+		std::chrono::steady_clock::now().time_since_epoch();
+	res.wall = wall.count();
+	//Per-thread, so that concurrent compilations
+	// (--batch, --serve) don't count each other's time
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) == 0){
+		res.user = toMillis(usage.ru_utime);
+		res.sys = toMillis(usage.ru_stime);
+	}
+	return res;
+}
+
+size_t TimeReport::beginPhase(const char * name){
+	size_t idx = phases.size();
+	for (size_t i = 0; i < phases.size(); i++){
+		if (phases[i].name == name){ idx = i; }
+	}
+	if (idx == phases.size()){
+		phases.push_back(Entry(name));
+	}
+	open.push_back(idx);
+	return idx;
+}
+
+void TimeReport::endPhase(size_t idx,
+	const Times& start, const Times& end
+){
+	phases[idx].times.add(start, end);
+	open.pop_back();
+}
+
+void TimeReport::addFunction(const std::string& name,
+	const Times& start, const Times& end
+){
+	if (open.empty()){ return; }
+	Entry& phase = phases[open.back()];
+	auto found = phase.rowOf.emplace(name, phase.functions.size());
+	if (found.second){ phase.functions.push_back(Entry(name)); }
+	phase.functions[found.first->second].times.add(start, end);
+}
+
+TimeReport * TimeReport::fork() const{
+	TimeReport * res = new TimeReport();
+	if (!open.empty()){
+		res->phases.push_back(Entry(phases[open.back()].name));
+		res->open.push_back(0);
+	}
+	return res;
+}
+
+size_t TimeReport::functionRows() const{
+	if (open.empty()){ return 0; }
+	return phases[open.back()].functions.size();
+}
+
+void TimeReport::mergeFunctions(const TimeReport * part,
+	size_t from, size_t to
+){
+	if (part->open.empty()){ return; }
+	const std::vector<Entry>& rows =
+		part->phases[part->open.back()].functions;
+	Times none;
+	for (size_t i = from; i < to && i < rows.size(); i++){
+		addFunction(rows[i].name, none, rows[i].times);
+	}
+}
+
+void TimeReport::addCPU(const Times& start, const Times& end){
+	if (open.empty()){ return; }
+	Times& times = phases[open.back()].times;
+	times.user += end.user - start.user;
+	times.sys += end.sys - start.sys;
+}
+
+static void printRow(std::ostream& out, const std::string& label,
+	const Times& times
+){
+	out << std::left << std::setw(30) << label << std::right
+		<< std::setw(12) << times.wall
+		<< std::setw(12) << times.user
+		<< std::setw(12) << times.sys << "\n";
+}
+
+void TimeReport::print(std::ostream& out){
+	std::ios::fmtflags flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << std::left << std::setw(30) << "Time report (ms)" << std::right
+		<< std::setw(12) << "wall"
+		<< std::setw(12) << "user"
+		<< std::setw(12) << "sys" << "\n";
+	Times total;
+	for (Entry& phase : phases){
+		printRow(out, " " + phase.name, phase.times);
+		for (Entry& fn : phase.functions){
+			printRow(out, "   " + fn.name, fn.times);
+		}
+		total.wall += phase.times.wall;
+		total.user += phase.times.user;
+		total.sys += phase.times.sys;
+	}
+	printRow(out, " total", total);
+	out.flags(flags);
+}
+
+static void printJSONTimes(std::ostream& out, const std::string& name,
+	const Times& times
+){
+	out << "\"name\": \"" << name << "\", "
+		<< "\"wall_ms\": " << times.wall << ", "
+		<< "\"user_ms\": " << times.user << ", "
+		<< "\"sys_ms\": " << times.sys;
+}
+
+void TimeReport::printJSON(std::ostream& out){
+	//Names are phase names and Crona identifiers, neither
+	// of which can hold characters that need escaping
+	std::ios::fmtflags flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << "{\n  \"phases\": [";
+	bool firstPhase = true;
+	for (Entry& phase : phases){
+		if (!firstPhase){ out << ","; }
+		firstPhase = false;
+		out << "\n    {";
+		printJSONTimes(out, phase.name, phase.times);
+		out << ", \"functions\": [";
+		bool firstFn = true;
+		for (Entry& fn : phase.functions){
+			if (!firstFn){ out << ", "; }
+			firstFn = false;
+			out << "{";
+			printJSONTimes(out, fn.name, fn.times);
+			out << "}";
+		}
+		out << "]}";
+	}
+	out << "\n  ]\n}\n";
+	out.flags(flags);
+}
+
+PhaseTimer::PhaseTimer(const char * nameIn)
+: timing(TimeReport::timing()), report(nullptr), tracer(nullptr),
+  name(nameIn), idx(0){
+	if (!timing){ return; }
+	report = TimeReport::active();
+	tracer = Tracer::active();
+	if (report != nullptr){ idx = report->beginPhase(name); }
+	start = Times::now();
+}
+
+PhaseTimer::~PhaseTimer(){
+	if (!timing){ return; }
+	Times end = Times::now();
+	if (report != nullptr){ report->endPhase(idx, start, end); }
+	if (tracer != nullptr){
+		tracer->span(name, "phase", start.wall, end.wall);
+	}
+}
+
+FunctionTimer::FunctionTimer(StrRef nameIn)
+: timing(TimeReport::timing()), report(nullptr), tracer(nullptr){
+	if (!timing){ return; }
+	report = TimeReport::active();
+	tracer = Tracer::active();
+	name = nameIn.str();
+	start = Times::now();
+}
+
+FunctionTimer::~FunctionTimer(){
+	if (!timing){ return; }
+	Times end = Times::now();
+	if (report != nullptr){ report->addFunction(name, start, end); }
+	if (tracer != nullptr){
+		tracer->span(name, "function", start.wall, end.wall);
+	}
+}
+
+}
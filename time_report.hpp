@@ -0,0 +1,133 @@
+#ifndef CRONA_TIME_REPORT_HPP
+#define CRONA_TIME_REPORT_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "str_ref.hpp"
+#include "trace.hpp"
+
+namespace crona{
+
+//Wall, user and system time, in milliseconds
+class Times{
+public:
+	Times() : wall(0), user(0), sys(0){ }
+	//The current time of the calling thread
+	static Times now();
+	void add(const Times& start, const Times& end){
+		wall += end.wall - start.wall;
+		user += end.user - start.user;
+		sys += end.sys - start.sys;
+	}
+	double wall;
+	double user;
+	double sys;
+};
+
+//Where a compilation's time went, phase by phase and (for
+// the analysis and lowering phases) function by function.
+// Timers record into the report that is active on their
+// thread; when neither a report nor a Tracer is active, 
+// they cost a single check of timing().
+class TimeReport{
+public:
+	static TimeReport * active(){ return current(); }
+	static void activate(TimeReport * report){
+		current() = report;
+		updateTiming();
+	}
+	//Whether a TimeReport or a Tracer is active on this
+	// thread, i.e. whether timers have anything to do
+	static bool timing(){ return timingFlag(); }
+	//Bring timing() up to date, after either activate()
+	static void updateTiming(){
+		timingFlag() = current() != nullptr || Tracer::active() != nullptr;
+	}
+
+	//Human-readable, in the style of gcc's -ftime-report
+	void print(std::ostream& out);
+	void printJSON(std::ostream& out);
+
+	//Times are taken per thread, so work that a phase hands
+	// to other threads is recorded with forks of the report,
+	// one per thread, and added back once they are done.
+	//
+	//A report for another thread, recording into the phase
+	// that is open in this one
+	TimeReport * fork() const;
+	//How many function rows have been recorded in the open
+	// phase, to pick some out for mergeFunctions
+	size_t functionRows() const;
+	//Add a fork's function rows [from, to) to the open phase
+	void mergeFunctions(const TimeReport * part, size_t from, size_t to);
+	//Add the CPU time another thread spent on the open phase
+	// between start and end (its wall time already overlaps
+	// the phase's own)
+	void addCPU(const Times& start, const Times& end);
+private:
+	friend class PhaseTimer;
+	friend class FunctionTimer;
+
+	class Entry{
+	public:
+		Entry(std::string nameIn) : name(nameIn){ }
+		std::string name;
+		Times times;
+		std::vector<Entry> functions;
+		//The index of each function's row in functions
+		std::unordered_map<std::string, size_t> rowOf;
+	};
+
+	size_t beginPhase(const char * name);
+	void endPhase(size_t idx, const Times& start, const Times& end);
+	void addFunction(const std::string& name,
+		const Times& start, const Times& end);
+
+	static TimeReport *& current(){
+		thread_local TimeReport * report = nullptr;
+		return report;
+	}
+	static bool& timingFlag(){
+		thread_local bool on = false;
+		return on;
+	}
+
+	std::vector<Entry> phases;
+	std::vector<size_t> open;
+};
+
+//Times one phase of the pipeline for as long as it is in
+// scope, and records it as a span for the active Tracer
+class PhaseTimer{
+public:
+	PhaseTimer(const char * nameIn);
+	~PhaseTimer();
+private:
+	bool timing;
+	TimeReport * report;
+	Tracer * tracer;
+	const char * name;
+	size_t idx;
+	Times start;
+};
+
+//Times the work done on one function within the current
+// phase
+class FunctionTimer{
+public:
+	FunctionTimer(StrRef nameIn);
+	~FunctionTimer();
+private:
+	bool timing;
+	TimeReport * report;
+	Tracer * tracer;
+	std::string name;
+	Times start;
+};
+
+}
+
+#endif
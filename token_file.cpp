@@ -0,0 +1,171 @@
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "token_file.hpp"
+#include "errors.hpp"
+#include "interner.hpp"
+
+namespace crona{
+
+using TokenKind = crona::Parser::token;
+
+static const char MAGIC[] = "CRTOK";
+static const size_t MAGIC_LEN = 5;
+static const int VERSION = 1;
+
+static void writeVarint(std::ostream& out, uint64_t val){
+	while (val >= 0x80){
+		out.put(static_cast<char>((val & 0x7F) | 0x80));
+		val >>= 7;
+	}
+	out.put(static_cast<char>(val));
+}
+
+static void badFile(const char * why){
+	std::string msg = "Bad token file: ";
+	msg += why;
+	throw new InternalError(msg.c_str());
+}
+
+static uint64_t readVarint(std::istream& in){
+	uint64_t val = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7){
+		int byte = in.get();
+		if (byte == EOF){ badFile("truncated"); }
+		val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0){ return val; }
+	}
+	badFile("number too long");
+	return 0;
+}
+
+//Token kinds are numbered from just after YYUNDEF, so each
+// fits in a byte
+static char kindByte(int kind){
+	int byte = kind - TokenKind::YYUNDEF;
+	if (byte <= 0 || byte > 0xFF){
+		throw new InternalError("Token kind out of range");
+	}
+	return static_cast<char>(byte);
+}
+
+void TokenFile::write(const TokenBuffer * tokens, size_t sourceSize,
+	std::ostream& out
+){
+	//Number each distinct text the first time it's seen
+	std::unordered_map<StrRef, uint64_t> index;
+	std::vector<StrRef> strings;
+	std::vector<uint64_t> payloads(tokens->size());
+	for (size_t i = 0; i < tokens->size(); i++){
+		Token * token = tokens->at(i);
+		StrRef text;
+		if (token->kind() == TokenKind::ID){
+			text = static_cast<IDToken *>(token)->value();
+		} else if (token->kind() == TokenKind::STRLITERAL){
+			text = static_cast<StrToken *>(token)->str();
+		} else if (token->kind() == TokenKind::INTLITERAL){
+			int num = static_cast<IntLitToken *>(token)->num();
+			payloads[i] = static_cast<uint64_t>(num);
+			continue;
+		} else {
+			continue;
+		}
+		auto found = index.find(text);
+		if (found == index.end()){
+			found = index.emplace(text, strings.size()).first;
+			strings.push_back(text);
+		}
+		payloads[i] = found->second;
+	}
+
+	out.write(MAGIC, MAGIC_LEN);
+	out.put(static_cast<char>(VERSION));
+	writeVarint(out, sourceSize);
+	writeVarint(out, strings.size());
+	for (StrRef text : strings){
+		writeVarint(out, text.size());
+		out << text;
+	}
+	writeVarint(out, tokens->size());
+	uint32_t last = 0;
+	for (size_t i = 0; i < tokens->size(); i++){
+		Token * token = tokens->at(i);
+		out.put(kindByte(token->kind()));
+		writeVarint(out, token->offset() - last);
+		last = token->offset();
+		int kind = token->kind();
+		if (kind == TokenKind::ID || kind == TokenKind::STRLITERAL
+		  || kind == TokenKind::INTLITERAL){
+			writeVarint(out, payloads[i]);
+		}
+	}
+	writeVarint(out, tokens->end() - last);
+}
+
+TokenBuffer * TokenFile::read(std::istream& in, size_t sourceSize){
+	char magic[MAGIC_LEN];
+	in.read(magic, MAGIC_LEN);
+	if (!in || memcmp(magic, MAGIC, MAGIC_LEN) != 0){
+		badFile("not a token file");
+	}
+	if (in.get() != VERSION){ badFile("unknown version"); }
+	if (readVarint(in) != sourceSize){
+		badFile("written for a different source");
+	}
+
+	uint64_t stringCount = readVarint(in);
+	std::vector<StrRef> strings;
+	for (uint64_t i = 0; i < stringCount; i++){
+		uint64_t len = readVarint(in);
+		if (len > sourceSize){ badFile("string too long"); }
+		char * text = static_cast<char *>(
+			Arena::allocateCurrent(static_cast<size_t>(len)));
+		in.read(text, static_cast<std::streamsize>(len));
+		if (!in){ badFile("truncated"); }
+		strings.push_back(StrRef(text, static_cast<size_t>(len)));
+	}
+	//Identifiers are interned once per distinct name
+	std::vector<uint32_t> ids(strings.size());
+	std::vector<bool> interned(strings.size(), false);
+
+	TokenBuffer * tokens = new TokenBuffer();
+	uint64_t tokenCount = readVarint(in);
+	uint64_t offset = 0;
+	for (uint64_t i = 0; i < tokenCount; i++){
+		int byte = in.get();
+		if (byte == EOF){ badFile("truncated"); }
+		int kind = byte + TokenKind::YYUNDEF;
+		offset += readVarint(in);
+		if (offset >= sourceSize){ badFile("token past the end"); }
+		uint32_t at = static_cast<uint32_t>(offset);
+		if (kind == TokenKind::ID || kind == TokenKind::STRLITERAL){
+			uint64_t which = readVarint(in);
+			if (which >= strings.size()){ badFile("bad string index"); }
+			size_t idx = static_cast<size_t>(which);
+			if (kind == TokenKind::STRLITERAL){
+				tokens->push(new StrToken(at, strings[idx]));
+				continue;
+			}
+			if (!interned[idx]){
+				ids[idx] = Interner::global().intern(strings[idx]);
+				interned[idx] = true;
+			}
+			tokens->push(new IDToken(at, strings[idx], ids[idx]));
+		} else if (kind == TokenKind::INTLITERAL){
+			uint64_t num = readVarint(in);
+			if (num > INT_MAX){ badFile("integer too large"); }
+			tokens->push(new IntLitToken(at, static_cast<int>(num)));
+		} else {
+			tokens->push(new Token(at, kind));
+		}
+	}
+	offset += readVarint(in);
+	if (offset > sourceSize){ badFile("end past the end"); }
+	tokens->setEnd(static_cast<size_t>(offset));
+	return tokens;
+}
+
+}
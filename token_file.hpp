@@ -0,0 +1,44 @@
+#ifndef CRONA_TOKEN_FILE_HPP
+#define CRONA_TOKEN_FILE_HPP
+
+#include <istream>
+#include <ostream>
+#include "token_stream.hpp"
+
+namespace crona{
+
+//A scanned token stream in a compact binary form, written
+// by -t <file> --format=bin and read back in place of
+// scanning with --tokens-from <file>. The layout is
+//   "CRTOK" 1           magic and version
+//   size                of the source that was scanned
+//   count, strings...   each a length and its bytes
+//   count, tokens...    each a kind byte, then its offset
+//                       (as the distance from the last
+//                       token's), then for ID and string
+//                       tokens the index of their text in
+//                       the strings, and for integer tokens
+//                       their value
+//   end                 distance from the last token to EOF
+// where every number is an unsigned LEB128 varint. Each
+// distinct identifier or string literal is stored once.
+//
+// Only the tokens are kept: positions are still looked up
+// in the source, and the scanner's error messages are not
+// repeated when the file is read.
+class TokenFile{
+public:
+	//Write the tokens scanned from a source of sourceSize
+	// bytes
+	static void write(const TokenBuffer * tokens, size_t sourceSize,
+		std::ostream& out);
+	//Read a stream written by write() for a source of
+	// sourceSize bytes. The tokens and their text are
+	// allocated in the active arena. Throws an InternalError
+	// if the file is malformed or is for another source.
+	static TokenBuffer * read(std::istream& in, size_t sourceSize);
+};
+
+}
+
+#endif
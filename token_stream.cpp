@@ -0,0 +1,59 @@
+#include "token_stream.hpp"
+
+namespace crona{
+
+using TokenKind = crona::Parser::token;
+
+int TokenBuffer::yylex(crona::Parser::semantic_type * const lval){
+	if (myNext >= myTokens.size()){
+		return TokenKind::END;
+	}
+	Token * token = myTokens[myNext++];
+	lval->transToken = token;
+	return token->kind();
+}
+
+int TokenSlice::yylex(crona::Parser::semantic_type * const lval){
+	if (myNext >= myEnd){
+		myLast = buffer->end();
+		return TokenKind::END;
+	}
+	Token * token = buffer->at(myNext++);
+	lval->transToken = token;
+	myLast = token->offset();
+	int kind = token->kind();
+	if (!skipBodies){ return kind; }
+
+	//Outside of bodies, every token is at the top level, so
+	// a semicolon or closing curly brace ends a declaration
+	if (kind == TokenKind::SEMICOLON || kind == TokenKind::RCURLY){
+		declStart = myNext;
+	} else if (kind == TokenKind::LCURLY){
+		//Skip to the matching brace, if there is one
+		int depth = 1;
+		for (size_t i = myNext; i < myEnd; i++){
+			int inner = buffer->at(i)->kind();
+			if (inner == TokenKind::LCURLY){
+				depth++;
+			} else if (inner == TokenKind::RCURLY && --depth == 0){
+				mySkipped.push_back(std::make_pair(declStart, i + 1));
+				myNext = i;
+				break;
+			}
+		}
+	}
+	return kind;
+}
+
+void TokenBuffer::outputTokens(std::ostream& outstream){
+	for (Token * token : myTokens){
+		outstream << token->toString() << std::endl;
+	}
+	LineCol end = SourceBuffer::locate(myEnd);
+	outstream << "EOF"
+	  << " [" << end.line
+	  << "," << end.col << "]"
+	  << std::endl;
+}
+
+}
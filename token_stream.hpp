@@ -0,0 +1,80 @@
+#ifndef CRONA_TOKEN_STREAM_HPP
+#define CRONA_TOKEN_STREAM_HPP
+
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "grammar.hh"
+#include "tokens.hpp"
+
+namespace crona{
+
+//Anything the parser can pull tokens from. The flex Scanner
+// is one source of tokens, but a TokenBuffer that has
+// already been filled by a scanner is another.
+class TokenStream{
+public:
+	virtual ~TokenStream(){ }
+	virtual int yylex(crona::Parser::semantic_type * const lval) = 0;
+};
+
+//A fully-scanned token stream. The buffer is filled once
+// (see Scanner::fill) and can then be written out with
+// outputTokens and/or handed to the Parser, so that the
+// input never needs to be scanned more than once.
+class TokenBuffer : public TokenStream{
+public:
+	TokenBuffer() : myNext(0), myEnd(0){ }
+	void push(Token * token){ myTokens.push_back(token); }
+	//Add other's tokens after this buffer's
+	void append(const TokenBuffer * other){
+		myTokens.insert(myTokens.end(), other->myTokens.begin(),
+			other->myTokens.end());
+	}
+	//Where the input ends, as a source offset
+	void setEnd(size_t offset){ myEnd = offset; }
+	size_t size() const { return myTokens.size(); }
+	Token * at(size_t idx) const { return myTokens[idx]; }
+	size_t end() const { return myEnd; }
+	void rewind(){ myNext = 0; }
+	virtual int yylex(crona::Parser::semantic_type * const lval) override;
+	void outputTokens(std::ostream& outstream);
+private:
+	std::vector<Token *> myTokens;
+	size_t myNext;
+	size_t myEnd;
+};
+
+//The tokens of a TokenBuffer from index from up to (not
+// including) to, as a stream of their own. With skipBodies
+// set, the tokens between the curly braces of each function
+// body are left out, so the parser sees every body as empty,
+// and the start and end index of each function's whole
+// declaration is kept in skipped(), to parse the body from
+// later (see FnDeclNode::deferBody).
+class TokenSlice : public TokenStream{
+public:
+	TokenSlice(const TokenBuffer * bufferIn, size_t from, size_t to,
+		bool skipBodiesIn = false)
+	: buffer(bufferIn), myNext(from), myEnd(to),
+	  skipBodies(skipBodiesIn), declStart(from), myLast(0){ }
+	virtual int yylex(crona::Parser::semantic_type * const lval) override;
+	//Where the last token handed out starts in the source,
+	// or where the input ends once END has been handed out
+	size_t lastOffset() const { return myLast; }
+	const std::vector<std::pair<size_t, size_t>>& skipped() const {
+		return mySkipped;
+	}
+private:
+	const TokenBuffer * buffer;
+	size_t myNext;
+	size_t myEnd;
+	bool skipBodies;
+	size_t declStart;
+	size_t myLast;
+	std::vector<std::pair<size_t, size_t>> mySkipped;
+};
+
+}
+
+#endif
@@ -58,66 +58,67 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
-Token::Token(size_t lineIn, size_t columnIn, int kindIn)
-  : myLine(lineIn), myCol(columnIn), myKind(kindIn){
+Token::Token(uint32_t offsetIn, int kindIn)
+  : myOffset(offsetIn), myKind(kindIn){
 }
 
 std::string Token::toString(){
-	return tokenKindString(kind())
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
+	return tokenKindString(kind()) + posString();
+}
+
+std::string Token::posString() const {
+	LineCol pos = SourceBuffer::locate(myOffset);
+	return " [" + std::to_string(pos.line)
+	+ "," + std::to_string(pos.col) + "]";
 }
 
 size_t Token::line() const { 
-	return this->myLine; 
+	return SourceBuffer::locate(myOffset).line;
 }
 
 size_t Token::col() const { 
-	return this->myCol; 
+	return SourceBuffer::locate(myOffset).col;
 }
 
 int Token::kind() const { 
 	return this->myKind; 
 }
 
-IDToken::IDToken(size_t lIn, size_t cIn, std::string vIn)
-  : Token(lIn, cIn, TokenKind::ID), myValue(vIn){ 
+IDToken::IDToken(uint32_t offsetIn, StrRef vIn, uint32_t idIn)
+  : Token(offsetIn, TokenKind::ID), myValue(vIn), myID(idIn){ 
 }
 
 std::string IDToken::toString(){
 	return tokenKindString(kind()) + ":"
 	+ this->myValue
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
+	+ posString();
 }
 
-const std::string IDToken::value() const { 
+StrRef IDToken::value() const { 
 	return this->myValue; 
 }
 
-StrToken::StrToken(size_t lIn, size_t cIn, std::string sIn)
-  : Token(lIn, cIn, TokenKind::STRLITERAL), myStr(sIn){
+StrToken::StrToken(uint32_t offsetIn, StrRef sIn)
+  : Token(offsetIn, TokenKind::STRLITERAL), myStr(sIn){
 }
 
 std::string StrToken::toString(){
 	return tokenKindString(kind()) + ":"
 	+ this->myStr
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
+	+ posString();
 }
 
-const std::string StrToken::str() const {
+StrRef StrToken::str() const {
 	return this->myStr;
 }
 
-IntLitToken::IntLitToken(size_t lIn, size_t cIn, int numIn)
-  : Token(lIn, cIn, TokenKind::INTLITERAL), myNum(numIn){}
+IntLitToken::IntLitToken(uint32_t offsetIn, int numIn)
+  : Token(offsetIn, TokenKind::INTLITERAL), myNum(numIn){}
 
 std::string IntLitToken::toString(){
 	return tokenKindString(kind()) + ":"
 	+ std::to_string(this->myNum)
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
+	+ posString();
 }
 
 int IntLitToken::num() const {
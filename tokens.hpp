@@ -1,45 +1,61 @@
 #ifndef CRONA_TOKEN_H
 #define CRONA_TOKEN_H
 
+#include <cstdint>
 #include <string>
+#include "str_ref.hpp"
+#include "arena.hpp"
+#include "source_buffer.hpp"
 
 namespace crona{
 
 class Token{
 public:
-	Token(size_t lineIn, size_t columnIn, int kindIn);
+	//offsetIn is where the token starts in the source
+	Token(uint32_t offsetIn, int kindIn);
+	//Tokens live in the compilation's Arena
+	static void * operator new(size_t size){
+		return Arena::allocateCurrent(size);
+	}
+	static void operator delete(void *){ }
 	virtual std::string toString();
+	uint32_t offset() const { return myOffset; }
+	//Looked up in the active SourceBuffer
 	size_t line() const;
 	size_t col() const;
 	int kind() const;
+protected:
+	std::string posString() const;
 private:
-	const size_t myLine;
-	const size_t myCol;
+	const uint32_t myOffset;
 	const int myKind;
 };
 
 class IDToken : public Token{
 public:
-	IDToken(size_t lIn, size_t cIn, std::string valIn);
-	const std::string value() const;
+	IDToken(uint32_t offsetIn, StrRef valIn, uint32_t idIn);
+	StrRef value() const;
+	//The identifier's key in the Interner
+	uint32_t id() const { return myID; }
 	virtual std::string toString() override;
 private:
-	const std::string myValue;
+	const StrRef myValue;
+	const uint32_t myID;
 	
 };
 
 class StrToken : public Token{
 public:
-	StrToken(size_t lIn, size_t cIn, std::string valIn);
+	StrToken(uint32_t offsetIn, StrRef valIn);
 	virtual std::string toString() override;
-	const std::string str() const;
+	StrRef str() const;
 private:
-	const std::string myStr;
+	const StrRef myStr;
 };
 
 class CharLitToken : public Token{
 public:
-	CharLitToken(size_t lIn, size_t cIn, char valIn);
+	CharLitToken(uint32_t offsetIn, char valIn);
 	virtual std::string toString() override;
 	char val() const;
 private:
@@ -48,7 +64,7 @@ private:
 
 class IntLitToken : public Token{
 public:
-	IntLitToken(size_t lIn, size_t cIn, int numIn);
+	IntLitToken(uint32_t offsetIn, int numIn);
 	virtual std::string toString() override;
 	int num() const;
 private:
@@ -0,0 +1,85 @@
+#include <atomic>
+#include <iomanip>
+#include <unistd.h>
+#include "trace.hpp"
+#include "time_report.hpp"
+
+namespace crona{
+
+Tracer::Tracer(){
+}
+
+void Tracer::activate(Tracer * tracer){
+	current() = tracer;
+	TimeReport::updateTiming();
+}
+
+size_t Tracer::threadID(){
+	static std::atomic<size_t> nextID(1);
+	thread_local size_t id = nextID++;
+	return id;
+}
+
+void Tracer::span(const std::string& name, const char * category,
+	double start, double end
+){
+	Event event;
+	event.name = name;
+	event.category = category;
+	event.start = start;
+	event.duration = end - start;
+	event.thread = threadID();
+	std::lock_guard<std::mutex> guard(lock);
+	events.push_back(event);
+}
+
+//Write str as the inside of a JSON string. Span names can be
+// file paths, which may hold quotes, backslashes or control
+// characters.
+static void writeEscaped(std::ostream& out, const std::string& str){
+	static const char * HEX = "0123456789abcdef";
+	for (char c : str){
+		unsigned char byte = static_cast<unsigned char>(c);
+		if (c == '"' || c == '\\'){
+			out << '\\' << c;
+		} else if (byte < 0x20){
+			out << "\\u00" << HEX[byte >> 4] << HEX[byte & 0xf];
+		} else {
+			out << c;
+		}
+	}
+}
+
+void Tracer::write(std::ostream& out){
+	std::lock_guard<std::mutex> guard(lock);
+
+	//Timestamps are in microseconds, counted from the
+	// earliest span
+	double origin = 0;
+	if (!events.empty()){ origin = events.front().start; }
+	for (const Event& event : events){
+		if (event.start < origin){ origin = event.start; }
+	}
+
+	std::ios::fmtflags flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	bool first = true;
+	for (const Event& event : events){
+		if (!first){ out << ","; }
+		first = false;
+		out << "\n  {\"name\": \"";
+		writeEscaped(out, event.name);
+		out << "\", \"cat\": \"";
+		writeEscaped(out, event.category);
+		out << "\", \"ph\": \"X\", "
+			<< "\"ts\": " << (event.start - origin) * 1000.0 << ", "
+			<< "\"dur\": " << event.duration * 1000.0 << ", "
+			<< "\"pid\": " << getpid() << ", "
+			<< "\"tid\": " << event.thread << "}";
+	}
+	out << "\n]}\n";
+	out.flags(flags);
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef CRONA_TRACE_HPP
+#define CRONA_TRACE_HPP
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace crona{
+
+//Collects spans of compiler work in the Chrome trace-event
+// format (which Perfetto and chrome://tracing both read).
+// The spans come from the PhaseTimer and FunctionTimer
+// scopes (see time_report.hpp) on every thread that the
+// tracer has been activated on; each span carries the
+// thread it ran on.
+class Tracer{
+public:
+	Tracer();
+
+	static Tracer * active(){ return current(); }
+	static void activate(Tracer * tracer);
+
+	//Record a span given its start and end in milliseconds
+	// on the steady clock (see Times::now)
+	void span(const std::string& name, const char * category,
+		double start, double end);
+	void write(std::ostream& out);
+
+	//A small number identifying the calling thread
+	static size_t threadID();
+private:
+	class Event{
+	public:
+		std::string name;
+		const char * category;
+		double start;
+		double duration;
+		size_t thread;
+	};
+
+	static Tracer *& current(){
+		thread_local Tracer * tracer = nullptr;
+		return tracer;
+	}
+
+	std::mutex lock;
+	std::vector<Event> events;
+};
+
+}
+
+#endif
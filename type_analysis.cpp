@@ -2,15 +2,22 @@
 
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "time_report.hpp"
 
 namespace crona {
 
-TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
+TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis,
+	size_t threads
+){
 	TypeAnalysis * typeAnalysis = new TypeAnalysis();
 	auto ast = nameAnalysis->ast;	
 	typeAnalysis->ast = ast;
 
-	ast->typeAnalysis(typeAnalysis);
+	if (threads > 1){
+		ParallelAnalysis::types(ast, typeAnalysis, threads);
+	} else {
+		ast->typeAnalysis(typeAnalysis);
+	}
 	if (typeAnalysis->hasError){
 		return nullptr;
 	}
@@ -20,7 +27,7 @@ TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 }
 
 void ProgramNode::typeAnalysis(TypeAnalysis * typing){
-	for (auto decl : *myGlobals){
+	for (auto decl : myGlobals){
 		decl->typeAnalysis(typing);
 	}
 	typing->nodeType(this, BasicType::VOID());
@@ -39,21 +46,21 @@ void VarDeclNode::typeAnalysis(TypeAnalysis * typing){
 }
 
 void FnDeclNode::typeAnalysis(TypeAnalysis * typing){
-	myRetType->typeAnalysis(typing);
-	const DataType * retDataType = typing->nodeType(myRetType);
+	//A cached function checked out when it was first compiled
+	if (myTemplate != nullptr){ return; }
+	FunctionTimer timer(myID->getName());
 
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
-	for (auto formal : *myFormals){
+	myRetType->typeAnalysis(typing);
+	for (auto formal : myFormals){
 		formal->typeAnalysis(typing);
-		formalTypes->push_back(typing->nodeType(formal));
 	}	
 
-	
-	typing->nodeType(this, new FnType(formalTypes, retDataType));
+	//Name analysis already produced the function's type
+	const FnType * fnType = myID->getSymbol()->getDataType()->asFn();
+	typing->nodeType(this, fnType);
 
-	typing->setCurrentFnType(typing->nodeType(this)->asFn());
-	for (auto stmt : *myBody){
+	typing->setCurrentFnType(fnType);
+	for (auto stmt : body()){
 		stmt->typeAnalysis(typing);
 	}
 	typing->setCurrentFnType(nullptr);
@@ -141,10 +148,8 @@ void AssignExpNode::typeAnalysis(TypeAnalysis * typing){
 
 void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 
-	std::list<const DataType *> * aList = new std::list<const DataType *>();
-	for (auto actual : *myArgs){
+	for (auto actual : myArgs){
 		actual->typeAnalysis(typing);
-		aList->push_back(typing->nodeType(actual));
 	}
 
 	SemSymbol * calleeSym = myID->getSymbol();
@@ -157,21 +162,19 @@ void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 		return;
 	}
 
-	const std::list<const DataType *>* fList = fnType->getFormalTypes();
-	if (aList->size() != fList->size()){
+	const std::vector<const DataType *>& fList = fnType->getFormalTypes();
+	if (myArgs.size() != fList.size()){
 		typing->errArgCount(line(), col());
 		//Note: we still consider the call to return the 
 		// return type
 	} else {
-		auto actualTypesItr = aList->begin();
-		auto formalTypesItr = fList->begin();
-		auto actualsItr = myArgs->begin();
-		while(actualTypesItr != aList->end()){
-			const DataType * actualType = *actualTypesItr;
-			const DataType * formalType = *formalTypesItr;
+		auto formalTypesItr = fList.begin();
+		auto actualsItr = myArgs.begin();
+		while(actualsItr != myArgs.end()){
 			ExpNode * actual = *actualsItr;
-			auto actualsItrOld = actualsItr;
-			actualTypesItr++;
+			const DataType * actualType = typing->nodeType(actual);
+			const DataType * formalType = *formalTypesItr;
+			ExpNode ** actualSlot = actualsItr;
 			formalTypesItr++;
 			actualsItr++;
 
@@ -195,10 +198,7 @@ void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 				//Promote
 				ByteToIntNode * up = new ByteToIntNode(actual);
 				typing->nodeType(up, BasicType::INT());
-				
-				actualsItrOld = myArgs->erase(actualsItrOld);
-				actualsItrOld = myArgs->insert(actualsItrOld, up);
-				
+				*actualSlot = up;
 				continue;
 			}
 
@@ -695,7 +695,7 @@ void IfStmtNode::typeAnalysis(TypeAnalysis * typing){
 			ErrorType::produce());
 	}
 
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->typeAnalysis(typing);
 	}
 
@@ -718,10 +718,10 @@ void IfElseStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->errIfCond(myCond->line(), myCond->col());
 		goodCond = false;
 	}
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		stmt->typeAnalysis(typing);
 	}
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		stmt->typeAnalysis(typing);
 	}
 	
@@ -742,7 +742,7 @@ void WhileStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->errWhileCond(myCond->line(), myCond->col());
 	}
 
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->typeAnalysis(typing);
 	}
 
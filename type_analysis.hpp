@@ -10,11 +10,10 @@ class NameAnalysis;
 namespace crona{
 
 // An instance of this class will be passed over the entire
-// AST. Rather than attaching types to each node, the 
-// TypeAnalysis class contains a map from each ASTNode to it's
-// DataType. Thus, instead of attaching a type field to most nodes,
-// one can instead map the node to it's type, or lookup the node
-// in the map.
+// AST. The type it finds for each node is kept on the node
+// itself (see ASTNode::dataType), so looking a type up is a
+// single read rather than a search of a map from nodes to
+// types.
 class TypeAnalysis {
 
 private:
@@ -25,7 +24,10 @@ private:
 	}
 
 public:
-	static TypeAnalysis * build(NameAnalysis * astRoot);
+	//With threads > 1, functions are typed on that many
+	// threads (see ParallelAnalysis)
+	static TypeAnalysis * build(NameAnalysis * astRoot,
+		size_t threads = 1);
 	//static TypeAnalysis * build();
 
 	//The type analysis has an instance variable to say whether
@@ -36,6 +38,21 @@ public:
 		return !hasError;
 	}
 
+	//A fresh analysis of the same AST, to type some functions
+	// in (perhaps on another thread) without touching this
+	// one, and then merge back into it
+	TypeAnalysis * fork(){
+		TypeAnalysis * res = new TypeAnalysis();
+		res->ast = ast;
+		return res;
+	}
+
+	//Take on any error of part, a fork of this (the types it
+	// found are already on the nodes)
+	void merge(TypeAnalysis * part){
+		hasError = hasError || part->hasError;
+	}
+
 	void setCurrentFnType(const FnType * type){
 		currentFnType = type;
 	}
@@ -46,22 +63,22 @@ public:
 
 	
 	//Set the type of a node. Note that the function name is 
-	// overloaded: this 2-argument nodeType puts a value into the
-	// map with a given type. 
-	void nodeType(const ASTNode * node, const DataType * type){
-		nodeToType[node] = type;
+	// overloaded: this 2-argument nodeType gives the node
+	// a type. 
+	void nodeType(ASTNode * node, const DataType * type){
+		node->setDataType(type);
 	}
 
-	//Gets the type of a node already placed in the map. Note
-	// that this function name is overloaded: the 1-argument nodeType
-	// gets the type of the given node out of the map.
+	//Gets the type already given to a node. Note that this
+	// function name is overloaded: the 1-argument nodeType
+	// gets the type of the given node.
 	const DataType * nodeType(const ASTNode * node){
-		const DataType * res = nodeToType[node];
+		const DataType * res = node->dataType();
 		if (res == nullptr){
 			const char * msg = "No type for node ";
 			throw new InternalError(msg);
 		}
-		return nodeToType[node];
+		return res;
 	}
 
 	//The following functions all report and error and 
@@ -185,7 +202,6 @@ public:
 		Report::fatal(line, col, "Bad index type");
 	}
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
 	const FnType * currentFnType;
 	bool hasError;
 public:
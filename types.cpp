@@ -6,6 +6,64 @@
 
 namespace crona{
 
+//Several compilations (see batch.cpp) and analysis threads
+// (see ParallelAnalysis) may be producing types at once, so
+// the tables of flyweights are locked
+
+BasicType * BasicType::produce(BaseType base){
+	//There are only four, all made the first time any is
+	// asked for (which C++ makes thread-safe), so this
+	// takes no lock
+	static BasicType * const flyweights[] = {
+		new BasicType(BaseType::INT), new BasicType(BaseType::VOID),
+		new BasicType(BaseType::BOOL), new BasicType(BaseType::BYTE)
+	};
+	return flyweights[static_cast<size_t>(base)];
+}
+
+ArrayType * ArrayType::produce(const BasicType * basicType, int length){
+	static HashMap<uint64_t, ArrayType *> flyweights;
+	static std::mutex flyweightsLock;
+	uint64_t key = static_cast<uint64_t>(basicType->getBaseType()) << 32
+		| static_cast<uint32_t>(length);
+	std::lock_guard<std::mutex> guard(flyweightsLock);
+	ArrayType *& fly = flyweights[key];
+	if (fly == nullptr){ fly = new ArrayType(basicType, length); }
+	return fly;
+}
+
+static size_t hashSignature(const std::vector<const DataType *>& formals,
+	const DataType * retType
+){
+	std::hash<const DataType *> hashType;
+	size_t res = hashType(retType);
+	for (const DataType * formal : formals){
+		res = res * 31 + hashType(formal);
+	}
+	return res;
+}
+
+FnType * FnType::produce(const std::vector<const DataType *>& formals,
+	const DataType * retType
+){
+	//Keyed by hashSignature, so that looking a signature up
+	// needs nothing built for the key
+	static std::unordered_multimap<size_t, FnType *> flyweights;
+	static std::mutex flyweightsLock;
+	size_t hash = hashSignature(formals, retType);
+	std::lock_guard<std::mutex> guard(flyweightsLock);
+	auto range = flyweights.equal_range(hash);
+	for (auto found = range.first; found != range.second; found++){
+		FnType * fly = found->second;
+		if (fly->myRetType == retType && fly->myFormalTypes == formals){
+			return fly;
+		}
+	}
+	FnType * newType = new FnType(formals, retType);
+	flyweights.emplace(hash, newType);
+	return newType;
+}
+
 std::string BasicType::getString() const{
 	std::string res = "";
 	switch(myBaseType){
@@ -2,7 +2,9 @@
 #define CRONA_DATA_TYPES
 
 #include <list>
+#include <mutex>
 #include <sstream>
+#include <vector>
 #include "errors.hpp"
 
 #include <unordered_map>
@@ -100,28 +102,14 @@ public:
 	// and ensures that the memory needs of a program are kept
 	// down: rather than having a distinct type for every base
 	// INT (for example), only one is constructed and kept in
-	// the flyweights list. That type is then re-used anywhere
-	// it's needed. 
+	// a table of flyweights. That type is then re-used
+	// anywhere it's needed, so two types are the same type
+	// exactly when they are the same pointer.
 
 	//Note the use of the static function declaration, which 
 	// means that no instance of BasicType is needed to call
 	// the function.
-	static BasicType * produce(BaseType base){
-		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<BasicType *> flyweights;
-		for(BasicType * fly : flyweights){
-			if (fly->getBaseType() == base){
-				return fly;
-			}
-		}
-		BasicType * newType = new BasicType(base);
-		flyweights.push_back(newType);
-		return newType;
-	}
+	static BasicType * produce(BaseType base);
 	const BasicType * asBasic() const override {
 		return this;
 	}
@@ -160,24 +148,9 @@ private:
 
 class ArrayType : public DataType{
 public:
-	static ArrayType * produce(const BasicType * basicType, int length){
-		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<ArrayType *> flyweights;
-		for(ArrayType * fly : flyweights){
-			if (fly->myBasicType == basicType){
-				if (fly->myLength == length){
-					return fly;
-				}
-			}
-		}
-		ArrayType * newType = new ArrayType(basicType, length);
-		flyweights.push_back(newType);
-		return newType;
-	}
+	//The one array of length elements of basicType (see
+	// BasicType::produce)
+	static ArrayType * produce(const BasicType * basicType, int length);
 
 	std::string getString() const override{
 		std::string res = myBasicType->getString();
@@ -209,19 +182,19 @@ private:
 };
 
 //DataType subclass to represent the type of a function. It will
-// have a list of argument types and a return type. 
+// have a list of argument types and a return type. Like the
+// other types, there is only one instance for each list of
+// argument types and return type.
 class FnType : public DataType{
 public:
-	FnType(const std::list<const DataType *>* formalsIn, const DataType * retTypeIn) 
-	: DataType(),
-	  myFormalTypes(formalsIn),
-	  myRetType(retTypeIn)
-	{
-	}
+	//The one function type taking formals and returning
+	// retType (see BasicType::produce)
+	static FnType * produce(const std::vector<const DataType *>& formals,
+		const DataType * retType);
 	std::string getString() const override{
 		std::string result = "";
 		bool first = true;
-		for (auto elt : *myFormalTypes){
+		for (auto elt : myFormalTypes){
 			if (first) { first = false; }
 			else { result += ","; }
 			result += elt->getString();
@@ -235,13 +208,20 @@ public:
 	const DataType * getReturnType() const {
 		return myRetType;
 	}
-	const std::list<const DataType *> * getFormalTypes() const {
+	const std::vector<const DataType *>& getFormalTypes() const {
 		return myFormalTypes;
 	}
 	virtual bool validVarType() const override { return false; }
 	virtual size_t getSize() const override { return 0; }
 private:
-	const std::list<const DataType *> * myFormalTypes;
+	FnType(const std::vector<const DataType *>& formalsIn,
+		const DataType * retTypeIn) 
+	: DataType(),
+	  myFormalTypes(formalsIn),
+	  myRetType(retTypeIn)
+	{
+	}
+	const std::vector<const DataType *> myFormalTypes;
 	const DataType * myRetType;
 };
 
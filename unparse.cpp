@@ -9,7 +9,7 @@ static void doIndent(std::ostream& out, int indent){
 }
 
 void ProgramNode::unparse(std::ostream& out, int indent){
-	for (DeclNode * decl : *myGlobals){
+	for (DeclNode * decl : myGlobals){
 		decl->unparse(out, indent);
 	}
 }
@@ -29,20 +29,25 @@ void FormalDeclNode::unparse(std::ostream& out, int indent){
 	getTypeNode()->unparse(out, 0);
 }
 
-void FnDeclNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent); 
+void FnDeclNode::unparseSignature(std::ostream& out){
 	myID->unparse(out, 0);
 	out << ":";
 	myRetType->unparse(out, 0); 
 	out << "(";
 	bool firstFormal = true;
-	for(auto formal : *myFormals){
+	for(auto formal : myFormals){
 		if (firstFormal) { firstFormal = false; }
 		else { out << ", "; }
 		formal->unparse(out, 0);
 	}
-	out << "){\n";
-	for(auto stmt : *myBody){
+	out << ")";
+}
+
+void FnDeclNode::unparse(std::ostream& out, int indent){
+	doIndent(out, indent); 
+	unparseSignature(out);
+	out << "{\n";
+	for(auto stmt : body()){
 		stmt->unparse(out, indent+1);
 	}
 	doIndent(out, indent);
@@ -86,7 +91,7 @@ void IfStmtNode::unparse(std::ostream& out, int indent){
 	out << "if (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -98,12 +103,12 @@ void IfElseStmtNode::unparse(std::ostream& out, int indent){
 	out << "if (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBodyTrue){
+	for (auto stmt : myBodyTrue){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
 	out << "} else {\n";
-	for (auto stmt : *myBodyFalse){
+	for (auto stmt : myBodyFalse){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -115,7 +120,7 @@ void WhileStmtNode::unparse(std::ostream& out, int indent){
 	out << "while (";
 	myCond->unparse(out, 0);
 	out << "){\n";
-	for (auto stmt : *myBody){
+	for (auto stmt : myBody){
 		stmt->unparse(out, indent + 1);
 	}
 	doIndent(out, indent);
@@ -150,7 +155,7 @@ void CallExpNode::unparse(std::ostream& out, int indent){
 	out << "(";
 	
 	bool firstArg = true;
-	for(auto arg : *myArgs){
+	for(auto arg : myArgs){
 		if (firstArg) { firstArg = false; }
 		else { out << ", "; }
 		arg->unparse(out, 0);
@@ -0,0 +1,93 @@
+#ifndef CRONA_WORKER_POOL_HPP
+#define CRONA_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crona{
+
+//A fixed set of worker threads pulling jobs off a shared
+// queue. Jobs are submitted with submit() and wait() blocks
+// until every submitted job has finished. The pool is
+// sized to the number of cores unless told otherwise.
+class WorkerPool{
+public:
+	WorkerPool(size_t threadsIn = 0) : pending(0), stopping(false){
+		size_t count = threadsIn;
+		if (count == 0){ count = defaultSize(); }
+		for (size_t i = 0; i < count; i++){
+			workers.push_back(std::thread([this](){ work(); }));
+		}
+	}
+
+	~WorkerPool(){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		jobReady.notify_all();
+		for (auto& worker : workers){
+			worker.join();
+		}
+	}
+
+	static size_t defaultSize(){
+		size_t cores = std::thread::hardware_concurrency();
+		if (cores == 0){ return 1; }
+		return cores;
+	}
+
+	size_t size() const { return workers.size(); }
+
+	void submit(std::function<void()> job){
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			jobs.push_back(job);
+			pending++;
+		}
+		jobReady.notify_one();
+	}
+
+	void wait(){
+		std::unique_lock<std::mutex> guard(lock);
+		allDone.wait(guard, [this](){ return pending == 0; });
+	}
+
+private:
+	void work(){
+		while (true){
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				jobReady.wait(guard, [this](){
+					return stopping || !jobs.empty();
+				});
+				if (jobs.empty()){ return; }
+				job = jobs.front();
+				jobs.pop_front();
+			}
+			job();
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				pending--;
+				if (pending == 0){ allDone.notify_all(); }
+			}
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex lock;
+	std::condition_variable jobReady;
+	std::condition_variable allDone;
+	size_t pending;
+	bool stopping;
+};
+
+}
+
+#endif